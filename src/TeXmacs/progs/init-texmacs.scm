@@ -115,7 +115,8 @@
 (use-modules (utils library smart-table))
 (use-modules (utils plugins plugin-convert))
 (use-modules (utils misc markup-funcs))
-(use-modules (utils handwriting handwriting))
+(lazy-define (utils handwriting handwriting)
+             learn-glyph learn-glyphs recognize-glyph)
 (define supports-email? (url-exists-in-path? "mmail"))
 (if supports-email? (use-modules (utils email email-tmfs)))
 ;(display* "time: " (- (texmacs-time) boot-start) "\n")
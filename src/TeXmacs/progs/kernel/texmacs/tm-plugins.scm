@@ -390,7 +390,8 @@
          (u2 "$PATH")
          (u3 (if after? (url-or u2 u1) (url-or u1 u2)))
          (p  (url-expand u3)))
-    (setenv "PATH" (url->system p))))
+    (setenv "PATH" (url->system p))
+    (url-resolve-reset)))
 
 (define (add-windows-program-path u after?)
   (add-to-path
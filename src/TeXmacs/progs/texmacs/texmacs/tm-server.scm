@@ -63,6 +63,9 @@
 (define (notify-fast-environments var val)
   (set-fast-environments (== val "on")))
 
+(define (notify-display-lists var val)
+  (set-display-lists (== val "on")))
+
 (define-preferences
   ("profile" "beginner" (lambda args (noop)))
   ("look and feel" "default" notify-look-and-feel)
@@ -71,6 +74,7 @@
   ("interactive questions" (get-default-interactive-questions) noop)
   ("language" (get-locale-language) notify-language)
   ("fast environments" "on" notify-fast-environments)
+  ("display lists" "off" notify-display-lists)
   ("show full context" "on" (lambda args (noop)))
   ("show table cells" (get-default-show-table-cells) (lambda args (noop)))
   ("show focus" "on" (lambda args (noop)))
@@ -147,6 +147,39 @@ texmacs_input_rep::put (char c) { // returns true when expecting input
   return block_done;
 }
 
+static inline bool
+is_data_control (char c) {
+  return c == DATA_ESCAPE || c == DATA_BEGIN ||
+         c == DATA_ABORT || c == DATA_END;
+}
+
+bool
+texmacs_input_rep::put (string s) { // returns true when expecting input
+  // Ordinary characters are passed to the buffer by whole spans.
+  // The flushers only act on the last character of the buffer when
+  // it is a newline (verbatim and latex) or a '>' (html),
+  // so that it suffices to flush at such characters and after each span.
+  bool block_done= false;
+  int i= 0, n= N(s);
+  while (i<n) {
+    if (status != STATUS_NORMAL || is_data_control (s[i])) {
+      if (put (s[i])) block_done= true;
+      i++;
+      continue;
+    }
+    char stop= '\0';
+    if (mode == MODE_VERBATIM || mode == MODE_LATEX) stop= '\n';
+    else if (mode == MODE_HTML) stop= '>';
+    int j= i;
+    while (j<n && s[j] != stop && !is_data_control (s[j])) j++;
+    if (j<n && s[j] == stop) j++;
+    buf << s (i, j);
+    flush ();
+    i= j;
+  }
+  return block_done;
+}
+
 void
 texmacs_input_rep::bof () {
   format = "verbatim";
@@ -60,6 +60,8 @@ public:
   bool get_contents (int kind, blackbox& bb);
   bool set_highlight (int lan, int col, int start, int end);
   bool get_highlight (int lan, array<int>& cols);
+  bool get_signature (array<int>& sig);
+  bool get_stamp (int& stamp);
 };
 
 /******************************************************************************
@@ -226,6 +228,18 @@ list_observer_rep::get_highlight (int lan, array<int>& cols) {
          (!is_nil (o2) && o2->get_highlight (lan, cols));
 }
 
+bool
+list_observer_rep::get_signature (array<int>& sig) {
+  return (!is_nil (o1) && o1->get_signature (sig)) ||
+         (!is_nil (o2) && o2->get_signature (sig));
+}
+
+bool
+list_observer_rep::get_stamp (int& stamp) {
+  return (!is_nil (o1) && o1->get_stamp (stamp)) ||
+         (!is_nil (o2) && o2->get_stamp (stamp));
+}
+
 /******************************************************************************
 * Creation of list observers
 ******************************************************************************/
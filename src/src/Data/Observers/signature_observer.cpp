@@ -0,0 +1,69 @@
+
+/******************************************************************************
+* MODULE     : signature_observer.cpp
+* DESCRIPTION: Attach search signatures to trees
+* COPYRIGHT  : (C) 2026  agent
+*******************************************************************************
+* A signature observer remembers a bit set of the trigrams which occur
+* in the strings of the tree to which it is attached. The observer
+* removes itself as soon as the tree or one of its descendants is modified,
+* so that signatures are only recomputed along the modified paths.
+* An empty signature stands for a saturated one (see tree_search.cpp).
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "modification.hpp"
+
+/******************************************************************************
+* Definition of the signature_observer_rep class
+******************************************************************************/
+
+class signature_observer_rep: public observer_rep {
+  array<int> sig;
+public:
+  signature_observer_rep (array<int> sig2): sig (sig2) {}
+  int get_type () { return OBSERVER_SIGNATURE; }
+  tm_ostream& print (tm_ostream& out) { return out << " signature"; }
+
+  void announce (tree& ref, modification mod);
+  bool get_signature (array<int>& sig);
+};
+
+/******************************************************************************
+* Call back routines and signature methods
+******************************************************************************/
+
+void
+signature_observer_rep::announce (tree& ref, modification mod) {
+  (void) mod;
+  remove_observer (ref->obs, observer (this));
+}
+
+bool
+signature_observer_rep::get_signature (array<int>& s) {
+  s= sig;
+  return true;
+}
+
+/******************************************************************************
+* Attaching and retrieving signatures
+******************************************************************************/
+
+observer
+signature_observer (array<int> sig) {
+  return tm_new<signature_observer_rep> (sig);
+}
+
+void
+attach_signature (tree& ref, array<int> sig) {
+  attach_observer (ref, signature_observer (sig));
+}
+
+bool
+obtain_signature (tree& ref, array<int>& sig) {
+  if (is_nil (ref->obs)) return false;
+  return ref->obs->get_signature (sig);
+}
@@ -0,0 +1,79 @@
+
+/******************************************************************************
+* MODULE     : stamp_observer.cpp
+* DESCRIPTION: Attach stamps to unmodified trees
+* COPYRIGHT  : (C) 2026  agent
+*******************************************************************************
+* A stamp observer attaches an integer to a tree and removes itself as soon
+* as the tree or one of its descendants is modified.  Data computed from
+* a tree can thus be reused as long as the tree still carries the stamp
+* under which the data were stored.
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "modification.hpp"
+
+/******************************************************************************
+* Definition of the stamp_observer_rep class
+******************************************************************************/
+
+class stamp_observer_rep: public observer_rep {
+  int stamp;
+public:
+  stamp_observer_rep (int stamp2): stamp (stamp2) {}
+  int get_type () { return OBSERVER_STAMP; }
+  tm_ostream& print (tm_ostream& out) { return out << " stamp"; }
+
+  void announce (tree& ref, modification mod);
+  bool get_stamp (int& s);
+};
+
+/******************************************************************************
+* Call back routines and stamp methods
+******************************************************************************/
+
+void
+stamp_observer_rep::announce (tree& ref, modification mod) {
+  (void) mod;
+  remove_observer (ref->obs, observer (this));
+}
+
+bool
+stamp_observer_rep::get_stamp (int& s) {
+  s= stamp;
+  return true;
+}
+
+/******************************************************************************
+* Attaching and retrieving stamps
+******************************************************************************/
+
+observer
+stamp_observer (int stamp) {
+  return tm_new<stamp_observer_rep> (stamp);
+}
+
+void
+attach_stamp (tree& ref, int stamp) {
+  attach_observer (ref, stamp_observer (stamp));
+}
+
+int
+attach_stamp (tree& ref) {
+  // stamps are unique, so that they can be shared by several caches
+  static int stamp_count= 0;
+  int stamp;
+  if (obtain_stamp (ref, stamp)) return stamp;
+  stamp= ++stamp_count;
+  attach_stamp (ref, stamp);
+  return stamp;
+}
+
+bool
+obtain_stamp (tree& ref, int& stamp) {
+  if (is_nil (ref->obs)) return false;
+  return ref->obs->get_stamp (stamp);
+}
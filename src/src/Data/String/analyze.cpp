@@ -1360,6 +1360,96 @@ overlapping (string s1, string s2) {
   return 0;
 }
 
+/******************************************************************************
+* Trigram signatures
+*******************************************************************************
+* A trigram signature is a fixed size bit set of hashed trigrams (and
+* single characters) occurring in a string. If a string occurs in another
+* one, then all bits of its signature are set in the signature of the other
+* string. Signatures are used for quickly discarding candidates for searches.
+* Since the false positive rate of a signature grows with its number of set
+* bits, signatures which become too dense are replaced by the empty array,
+* which stands for a saturated signature that contains everything.
+******************************************************************************/
+
+static inline void
+signature_set (array<int>& sig, unsigned int h) {
+  h= (h ^ (h >> 10)) & (32 * N(sig) - 1);
+  sig[h >> 5] |= (int) (((unsigned int) 1) << (h & 31));
+}
+
+static inline bool
+signature_test (array<int>& sig, unsigned int h) {
+  h= (h ^ (h >> 10)) & (32 * N(sig) - 1);
+  return (sig[h >> 5] & (int) (((unsigned int) 1) << (h & 31))) != 0;
+}
+
+static inline unsigned int
+unigram_hash (string s, int i) {
+  return ((unsigned int) (unsigned char) s[i]) * 2654435761U;
+}
+
+static inline unsigned int
+trigram_hash (string s, int i) {
+  unsigned int h= (unsigned int) (unsigned char) s[i];
+  h= (h << 8) + ((unsigned int) (unsigned char) s[i+1]);
+  h= (h << 8) + ((unsigned int) (unsigned char) s[i+2]);
+  return (h + 1) * 2246822519U;
+}
+
+array<int>
+trigram_signature (int words) {
+  // the number of words should be a power of two
+  array<int> sig (words);
+  for (int i=0; i<words; i++) sig[i]= 0;
+  return sig;
+}
+
+void
+trigram_signature_add (array<int>& sig, string s) {
+  int i, n= N(s);
+  if (N(sig) == 0) return;
+  for (i=0; i<n; i++) {
+    signature_set (sig, unigram_hash (s, i));
+    if (i+2 < n) signature_set (sig, trigram_hash (s, i));
+  }
+}
+
+void
+trigram_signature_add (array<int>& sig, array<int> other) {
+  if (N(sig) == 0) return;
+  if (N(other) == 0) { sig= array<int> (); return; }
+  ASSERT (N(sig) == N(other), "signatures of different sizes");
+  for (int i=0; i<N(sig); i++) sig[i] |= other[i];
+}
+
+bool
+trigram_signature_saturated (array<int> sig, int num, int den) {
+  // a signature is saturated if more than num/den of its bits are set
+  int i, count= 0;
+  if (N(sig) == 0) return true;
+  for (i=0; i<N(sig); i++) {
+    unsigned int w= (unsigned int) sig[i];
+    while (w != 0) { w &= w - 1; count++; }
+  }
+  return count * den > 32 * N(sig) * num;
+}
+
+bool
+trigram_signature_contains (array<int> sig, string s) {
+  int i, n= N(s);
+  if (N(sig) == 0) return true;
+  if (n < 3) {
+    for (i=0; i<n; i++)
+      if (!signature_test (sig, unigram_hash (s, i))) return false;
+  }
+  else {
+    for (i=0; i+2<n; i++)
+      if (!signature_test (sig, trigram_hash (s, i))) return false;
+  }
+  return true;
+}
+
 string
 replace (string s, string what, string by) {
   int i, n= N(s);
@@ -134,6 +134,11 @@ int    search_backwards (string what, int pos, string in);
 int    count_occurrences (string what, string in);
 int    count_occurrences (string what, string in);
 bool   occurs (string what, string in);
+array<int> trigram_signature (int words= 32);
+void   trigram_signature_add (array<int>& sig, string s);
+void   trigram_signature_add (array<int>& sig, array<int> other);
+bool   trigram_signature_contains (array<int> sig, string what);
+bool   trigram_signature_saturated (array<int> sig, int num, int den);
 int    overlapping (string s1, string s2);
 string replace (string s, string what, string by);
 bool   match_wildcard (string s, string w);
@@ -218,6 +218,78 @@ search_concat (tree t, tree what, int pos, int i,
   }
 }
 
+/******************************************************************************
+* Trigram signatures for pruning the search
+*******************************************************************************
+* Large subtrees of the edit tree are annotated with a bit set of the
+* trigrams which occur in their strings (see signature_observer.cpp).
+* Subtrees whose signatures do not contain all trigrams of the searched
+* strings cannot contain any match and are skipped. Signatures are dropped
+* upon modification and lazily recomputed during the next search.
+* In order to keep the false positive rate below (1/3)^k for searches
+* of k trigrams, signatures with more than a third of their bits set are
+* stored as saturated (empty) signatures, which are never used for pruning.
+* Saturation propagates upwards, so that large subtrees like whole sections
+* are simply traversed and the pruning happens at the paragraph level.
+******************************************************************************/
+
+#define SIGNATURE_THRESHOLD 64
+
+static void
+tree_signature (array<int>& sig, int& len, tree& t) {
+  if (is_atomic (t)) {
+    trigram_signature_add (sig, t->label);
+    len += N(t->label);
+    return;
+  }
+  array<int> tsig;
+  if (obtain_signature (t, tsig)) {
+    trigram_signature_add (sig, tsig);
+    len += SIGNATURE_THRESHOLD;
+    return;
+  }
+  int tlen= 0;
+  tsig= trigram_signature ();
+  for (int i=0; i<N(t); i++) {
+    tree_signature (tsig, tlen, t[i]);
+    if (N(tsig) == 0) break;
+  }
+  if (trigram_signature_saturated (tsig, 1, 3)) tsig= array<int> ();
+  if (tlen >= SIGNATURE_THRESHOLD || N(tsig) == 0) attach_signature (t, tsig);
+  trigram_signature_add (sig, tsig);
+  len += tlen;
+}
+
+static bool
+search_required (array<string>& req, tree what) {
+  if (is_atomic (what)) {
+    if (N(what->label) == 0) return false;
+    req << what->label;
+    return true;
+  }
+  else if (is_concat (what)) {
+    for (int i=0; i<N(what); i++)
+      if (is_atomic (what[i]) && N(what[i]->label) != 0)
+        req << what[i]->label;
+      else if (!is_func (what[i], WILDCARD, 1)) return false;
+    return N(req) != 0;
+  }
+  else return false;
+}
+
+bool
+search_may_contain (tree& t, tree what) {
+  if (is_atomic (t) || !ip_attached (obtain_ip (t))) return true;
+  array<string> req;
+  if (!search_required (req, what)) return true;
+  int len= 0;
+  array<int> sig= trigram_signature ();
+  tree_signature (sig, len, t);
+  for (int i=0; i<N(req); i++)
+    if (!trigram_signature_contains (sig, req[i])) return false;
+  return true;
+}
+
 /******************************************************************************
 * Searching
 ******************************************************************************/
@@ -325,6 +397,7 @@ search (range_set& sel, tree t, tree what, path p) {
   if (N(sel) > search_max_hits) return;
   if (is_atomic (t))
     search_string (sel, t->label, what, p);
+  else if (!search_may_contain (t, what)) return;
   else if (is_func (t, CONCAT) && is_func (what, CONCAT))
     search_concat (sel, t, what, p);
   else if (is_func (t, DOCUMENT) && is_func (what, DOCUMENT))
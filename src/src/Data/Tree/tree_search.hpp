@@ -14,5 +14,6 @@
 #include "tree_select.hpp"
 
 range_set search (tree t, tree what, path p, int limit= 1000000);
+bool search_may_contain (tree& t, tree what);
 
 #endif // defined TREE_SEARCH_H
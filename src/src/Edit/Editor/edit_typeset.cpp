@@ -26,6 +26,7 @@
 
 //box empty_box (path ip, int x1=0, int y1=0, int x2=0, int y2=0);
 bool enable_fastenv= false;
+void table_memo_reset ();
 
 /******************************************************************************
 * Contructors, destructors and notification of modifications
@@ -668,6 +669,7 @@ edit_typeset_rep::typeset (SI& x1, SI& y1, SI& x2, SI& y2) {
     }
     missing_nr= N(env->missing);
     redefined_nr= N(env->redefined);
+    table_memo_reset ();
     ::notify_assign (ttt, path(), ttt->br->st);
   }
 }
@@ -686,5 +688,6 @@ edit_typeset_rep::typeset_invalidate_all () {
   //cout << "Invalidate all\n";
   notify_change (THE_ENVIRONMENT);
   typeset_preamble ();
+  table_memo_reset ();
   ::notify_assign (ttt, path(), subtree (et, rp));
 }
@@ -25,6 +25,7 @@ protected:
   tree        what_stack;    // last search trees
   tree        replace_by;    // replace tree
   int         nr_replaced;   // number of replaced occurrences
+  bool        search_prune;  // skip subtrees which cannot contain matches
 
   path        spell_end_p;   // spell check until here
   string      spell_s;       // the word being checked
@@ -56,6 +57,8 @@ public:
   /* search and replace */
   path test_sub (path p, tree t);
   path test (path p, tree t);
+  bool step_skip (tree& st, int l);
+  void step_fast (bool forward);
   void step_ascend (bool forward);
   void step_descend (bool forward);
   void step_horizontal (bool forward);
@@ -14,12 +14,13 @@
 #include "drd_std.hpp"
 #include "drd_mode.hpp"
 #include "analyze.hpp"
+#include "tree_search.hpp"
 
 /******************************************************************************
 * Constructor and destructor
 ******************************************************************************/
 
-edit_replace_rep::edit_replace_rep () {}
+edit_replace_rep::edit_replace_rep (): search_prune (false) {}
 edit_replace_rep::~edit_replace_rep () {}
 
 /******************************************************************************
@@ -236,6 +237,28 @@ edit_replace_rep::test (path p, tree t) {
 * Traversal of the edit tree
 ******************************************************************************/
 
+bool
+edit_replace_rep::step_skip (tree& st, int l) {
+  if (!search_prune || !is_atomic (search_what)) return false;
+  if (N(search_what->label) == 0) return false;
+  return !search_may_contain (st[l], search_what);
+}
+
+void
+edit_replace_rep::step_fast (bool forward) {
+  // jump to the next occurrence of search_what inside the current string
+  if (search_at == rp || !is_atomic (search_what)) return;
+  string w= search_what->label;
+  tree st= subtree (et, path_up (search_at));
+  if (N(w) == 0 || is_compound (st)) return;
+  string s= st->label;
+  int l= last_item (search_at);
+  int pos= (forward? tm_search_forwards (w, l, s):
+                     tm_search_backwards (w, l, s));
+  if (pos < 0) pos= (forward? N(s): 0);
+  search_at= path_up (search_at) * pos;
+}
+
 void
 edit_replace_rep::step_ascend (bool forward) {
   // cout << "Step ascend at " << search_at << "\n";
@@ -247,7 +270,8 @@ edit_replace_rep::step_ascend (bool forward) {
     l = last_item (search_at);
     // cout << "  st= " << st << "\n";
     // cout << "  l = " << l << "\n";
-    if ((l<0) || (l>=N(st)) || drd->is_accessible_child (st, l)) break;
+    if ((l<0) || (l>=N(st)) ||
+        (drd->is_accessible_child (st, l) && !step_skip (st, l))) break;
     search_at= path_add (search_at, forward? 1: -1);
   }
 
@@ -302,7 +326,7 @@ edit_replace_rep::step_horizontal (bool forward) {
 	else {
 	  int i;
 	  for (i=l; i<N(st); i++)
-	    if (drd->is_accessible_child (st, i)) {
+	    if (drd->is_accessible_child (st, i) && !step_skip (st, i)) {
 	      search_at= path_up (search_at) * i;
 	      step_descend (forward);
 	      return;
@@ -326,7 +350,7 @@ edit_replace_rep::step_horizontal (bool forward) {
 	else {
 	  int i;
 	  for (i=l; i>=0; i--)
-	    if (drd->is_accessible_child (st, i)) {
+	    if (drd->is_accessible_child (st, i) && !step_skip (st, i)) {
 	      search_at= path_up (search_at) * i;
 	      step_descend (forward);
 	      return;
@@ -359,7 +383,10 @@ edit_replace_rep::next_match (bool forward) {
     if (get_init_string (MODE) == "src" || inside ("show-preamble"))
       new_mode= DRD_ACCESS_SOURCE;
     int old_mode= set_access_mode (new_mode);
+    search_prune= true;
     step_horizontal (forward);
+    step_fast (forward);
+    search_prune= false;
     set_access_mode (old_mode);
   }
 }
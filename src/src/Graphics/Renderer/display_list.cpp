@@ -0,0 +1,601 @@
+
+/******************************************************************************
+* MODULE     : display_list.cpp
+* DESCRIPTION: flat recordings of rendering operations
+* COPYRIGHT  : (C) 2026  agent
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#include "display_list.hpp"
+
+#define DL_ORIGIN          0   // ox oy
+#define DL_CLIP            1   // x1 y1 x2 y2 (absolute coordinates)
+#define DL_TRANSFORM       2   // frame (-1 for reset)
+#define DL_PENCIL          3   // pencil (-1 for the initial one)
+#define DL_BRUSH           4   // brush (-1 for the initial one)
+#define DL_BACKGROUND      5   // brush (-1 for the initial one)
+#define DL_GLYPHS          6   // font n x1 y1 x2 y2 c_1 x_1 y_1 ... c_n y_n
+#define DL_LINE            7   // x1 y1 x2 y2
+#define DL_LINES           8   // coords
+#define DL_CLEAR           9   // x1 y1 x2 y2
+#define DL_CLEAR_PATTERN  10   // x1 y1 x2 y2
+#define DL_FILL           11   // x1 y1 x2 y2
+#define DL_ARC            12   // x1 y1 x2 y2 alpha delta
+#define DL_FILL_ARC       13   // x1 y1 x2 y2 alpha delta
+#define DL_POLYGON        14   // coords convex
+#define DL_TRIANGLE       15   // x1 y1 x2 y2 x3 y3
+#define DL_PICTURE        16   // picture x y alpha
+#define DL_SCALABLE       17   // image x y alpha
+#define DL_ANCHOR         18   // label x1 y1 x2 y2
+#define DL_HREF           19   // label x1 y1 x2 y2
+#define DL_TOC_ENTRY      20   // kind title x y
+
+#define DL_INFINITY (1 << 29)
+#define DL_MAX_MEMORY 64000000
+
+static int display_list_memory= 0;
+
+/******************************************************************************
+* Display lists
+******************************************************************************/
+
+static inline SI
+residue (SI x, SI pixel) {
+  SI r= x % pixel;
+  return r < 0? r + pixel: r;
+}
+
+display_list_rep::display_list_rep (renderer ren):
+  ox (residue (ren->ox, ren->pixel)), oy (residue (ren->oy, ren->pixel)),
+  pixel (ren->pixel), zoomf (ren->zoomf), shrinkf (ren->shrinkf),
+  brushpx (ren->brushpx), thicken (ren->thicken),
+  screen (ren->is_screen), printer (ren->is_printer ()),
+  reversed (reverse_colors), bytes (0) {}
+
+display_list_rep::~display_list_rep () {
+  display_list_memory -= bytes;
+}
+
+display_list::display_list (renderer ren):
+  rep (tm_new<display_list_rep> (ren)) {}
+
+int
+display_list_rep::memory () {
+  int i, r= sizeof (display_list_rep) + N(ops) * sizeof (int);
+  r += (N(fngs) + N(pens) + N(brushes) + N(pics) + N(ims) + N(frames) +
+	N(strs) + N(coords)) * sizeof (pointer);
+  for (i=0; i<N(strs); i++) r += N(strs[i]);
+  for (i=0; i<N(coords); i++) r += N(coords[i]) * sizeof (SI);
+  return r;
+}
+
+bool
+is_compatible (display_list dl, renderer ren) {
+  return
+    (dl->pixel == ren->pixel) && (dl->zoomf == ren->zoomf) &&
+    (dl->shrinkf == ren->shrinkf) && (dl->brushpx == ren->brushpx) &&
+    (dl->thicken == ren->thicken) && (dl->screen == ren->is_screen) &&
+    (dl->printer == ren->is_printer ()) && (dl->reversed == reverse_colors) &&
+    (dl->ox == residue (ren->ox, ren->pixel)) &&
+    (dl->oy == residue (ren->oy, ren->pixel));
+}
+
+bool
+keep_display_list (display_list dl) {
+  // reserve memory for dl, unless this would exceed DL_MAX_MEMORY
+  int mem= dl->memory ();
+  if (display_list_memory + mem - dl->bytes > DL_MAX_MEMORY) return false;
+  display_list_memory += mem - dl->bytes;
+  dl->bytes= mem;
+  return true;
+}
+
+/******************************************************************************
+* The recording renderer
+******************************************************************************/
+
+class display_list_recorder_rep: public renderer_rep {
+  display_list dl;
+  array<int>&  ops;
+  SI           lox, loy;   // origin of the last recorded operation
+  int          run;        // position of the length of the current glyph run
+  font_glyphs  run_fng;    // font of the current glyph run
+  pencil       pen, pen0;
+  brush        fg, fg0;
+  brush        bg, bg0;
+
+public:
+  display_list_recorder_rep (display_list dl, renderer ren);
+  void sync ();
+  bool is_printer ();
+
+  void   set_transformation (frame fr);
+  void   reset_transformation ();
+  void   set_clipping (SI x1, SI y1, SI x2, SI y2, bool restore= false);
+  pencil get_pencil ();
+  brush  get_brush ();
+  brush  get_background ();
+  void   set_pencil (pencil p);
+  void   set_brush (brush b);
+  void   set_background (brush b);
+
+  void   draw (int char_code, font_glyphs fn, SI x, SI y);
+  void   line (SI x1, SI y1, SI x2, SI y2);
+  void   lines (array<SI> x, array<SI> y);
+  void   clear (SI x1, SI y1, SI x2, SI y2);
+  void   clear_pattern (SI x1, SI y1, SI x2, SI y2);
+  void   fill (SI x1, SI y1, SI x2, SI y2);
+  void   arc (SI x1, SI y1, SI x2, SI y2, int alpha, int delta);
+  void   fill_arc (SI x1, SI y1, SI x2, SI y2, int alpha, int delta);
+  void   polygon (array<SI> x, array<SI> y, bool convex=true);
+  void   draw_triangle (SI x1, SI y1, SI x2, SI y2, SI x3, SI y3);
+  void   draw_picture (picture p, SI x, SI y, int alpha);
+  void   draw_scalable (scalable im, SI x, SI y, int alpha);
+
+  void fetch (SI x1, SI y1, SI x2, SI y2, renderer ren, SI x, SI y);
+  void new_shadow (renderer& ren);
+  void delete_shadow (renderer& ren);
+  void get_shadow (renderer ren, SI x1, SI y1, SI x2, SI y2);
+  void put_shadow (renderer ren, SI x1, SI y1, SI x2, SI y2);
+  void apply_shadow (SI x1, SI y1, SI x2, SI y2);
+
+  void anchor (string label, SI x1, SI y1, SI x2, SI y2);
+  void href (string label, SI x1, SI y1, SI x2, SI y2);
+  void toc_entry (string kind, string title, SI x, SI y);
+};
+
+display_list_recorder_rep::display_list_recorder_rep (
+  display_list dl2, renderer ren):
+    renderer_rep (ren->is_screen), dl (dl2), ops (dl->ops),
+    lox (dl->ox), loy (dl->oy), run (-1),
+    pen (ren->get_pencil ()), pen0 (pen),
+    fg (ren->get_brush ()), fg0 (fg),
+    bg (ren->get_background ()), bg0 (bg)
+{
+  ox= dl->ox; oy= dl->oy;
+  cx1= cy1= MINUS_INFINITY;
+  cx2= cy2= PLUS_INFINITY;
+  zoomf  = dl->zoomf;
+  shrinkf= dl->shrinkf;
+  pixel  = dl->pixel;
+  brushpx= dl->brushpx;
+  thicken= dl->thicken;
+  cur_page= ren->cur_page;
+}
+
+renderer
+display_list_recorder (display_list dl, renderer ren) {
+  return tm_new<display_list_recorder_rep> (dl, ren);
+}
+
+void
+display_list_recorder_rep::sync () {
+  run= -1;
+  if (ox != lox || oy != loy) {
+    ops << DL_ORIGIN << ox << oy;
+    lox= ox; loy= oy;
+  }
+}
+
+bool
+display_list_recorder_rep::is_printer () {
+  return dl->printer;
+}
+
+/******************************************************************************
+* Recording the graphical state
+******************************************************************************/
+
+void
+display_list_recorder_rep::set_transformation (frame fr) {
+  sync ();
+  ops << DL_TRANSFORM << N(dl->frames);
+  dl->frames << fr;
+}
+
+void
+display_list_recorder_rep::reset_transformation () {
+  sync ();
+  ops << DL_TRANSFORM << -1;
+}
+
+void
+display_list_recorder_rep::set_clipping (
+  SI x1, SI y1, SI x2, SI y2, bool restore)
+{
+  renderer_rep::set_clipping (x1, y1, x2, y2, restore);
+  sync ();
+  ops << DL_CLIP << cx1 << cy1 << cx2 << cy2;
+}
+
+pencil
+display_list_recorder_rep::get_pencil () {
+  return pen;
+}
+
+brush
+display_list_recorder_rep::get_brush () {
+  return fg;
+}
+
+brush
+display_list_recorder_rep::get_background () {
+  return bg;
+}
+
+void
+display_list_recorder_rep::set_pencil (pencil p) {
+  sync ();
+  pen= p;
+  if (p.operator -> () == pen0.operator -> ()) ops << DL_PENCIL << -1;
+  else {
+    ops << DL_PENCIL << N(dl->pens);
+    dl->pens << p;
+  }
+}
+
+void
+display_list_recorder_rep::set_brush (brush b) {
+  sync ();
+  fg = b;
+  pen= pencil (b);
+  if (b.operator -> () == fg0.operator -> ()) ops << DL_BRUSH << -1;
+  else {
+    ops << DL_BRUSH << N(dl->brushes);
+    dl->brushes << b;
+  }
+}
+
+void
+display_list_recorder_rep::set_background (brush b) {
+  sync ();
+  bg= b;
+  if (b.operator -> () == bg0.operator -> ()) ops << DL_BACKGROUND << -1;
+  else {
+    ops << DL_BACKGROUND << N(dl->brushes);
+    dl->brushes << b;
+  }
+}
+
+/******************************************************************************
+* Recording drawing operations
+******************************************************************************/
+
+void
+display_list_recorder_rep::draw (int c, font_glyphs fng, SI x, SI y) {
+  if (run < 0 || fng.rep != run_fng.rep || ox != lox || oy != loy) {
+    sync ();
+    ops << DL_GLYPHS << N(dl->fngs) << 0
+	<< DL_INFINITY << DL_INFINITY << -DL_INFINITY << -DL_INFINITY;
+    dl->fngs << fng;
+    run= N(ops) - 5;
+    run_fng= fng;
+  }
+  ops << c << x << y;
+  ops[run]++;
+
+  // Glyphs are rasterized at a finer resolution than the pixel,
+  // so measuring their rasters in pixels overestimates their extents
+  SI x1= -DL_INFINITY, y1= -DL_INFINITY, x2= DL_INFINITY, y2= DL_INFINITY;
+  glyph gl= fng->get (c);
+  if (!is_nil (gl)) {
+    x1= x - (gl->xoff + 1) * pixel;
+    x2= x + (gl->width - gl->xoff + 1) * pixel;
+    y1= y - (gl->height - gl->yoff + 1) * pixel;
+    y2= y + (gl->yoff + 1) * pixel;
+  }
+  ops[run+1]= min (ops[run+1], x1);
+  ops[run+2]= min (ops[run+2], y1);
+  ops[run+3]= max (ops[run+3], x2);
+  ops[run+4]= max (ops[run+4], y2);
+}
+
+void
+display_list_recorder_rep::line (SI x1, SI y1, SI x2, SI y2) {
+  sync ();
+  ops << DL_LINE << x1 << y1 << x2 << y2;
+}
+
+void
+display_list_recorder_rep::lines (array<SI> x, array<SI> y) {
+  sync ();
+  ops << DL_LINES << N(dl->coords);
+  dl->coords << x << y;
+}
+
+void
+display_list_recorder_rep::clear (SI x1, SI y1, SI x2, SI y2) {
+  sync ();
+  ops << DL_CLEAR << x1 << y1 << x2 << y2;
+}
+
+void
+display_list_recorder_rep::clear_pattern (SI x1, SI y1, SI x2, SI y2) {
+  sync ();
+  ops << DL_CLEAR_PATTERN << x1 << y1 << x2 << y2;
+}
+
+void
+display_list_recorder_rep::fill (SI x1, SI y1, SI x2, SI y2) {
+  sync ();
+  ops << DL_FILL << x1 << y1 << x2 << y2;
+}
+
+void
+display_list_recorder_rep::arc (SI x1, SI y1, SI x2, SI y2, int a, int d) {
+  sync ();
+  ops << DL_ARC << x1 << y1 << x2 << y2 << a << d;
+}
+
+void
+display_list_recorder_rep::fill_arc (SI x1, SI y1, SI x2, SI y2, int a, int d) {
+  sync ();
+  ops << DL_FILL_ARC << x1 << y1 << x2 << y2 << a << d;
+}
+
+void
+display_list_recorder_rep::polygon (array<SI> x, array<SI> y, bool convex) {
+  sync ();
+  ops << DL_POLYGON << N(dl->coords) << (convex? 1: 0);
+  dl->coords << x << y;
+}
+
+void
+display_list_recorder_rep::draw_triangle (
+  SI x1, SI y1, SI x2, SI y2, SI x3, SI y3)
+{
+  sync ();
+  ops << DL_TRIANGLE << x1 << y1 << x2 << y2 << x3 << y3;
+}
+
+void
+display_list_recorder_rep::draw_picture (picture p, SI x, SI y, int alpha) {
+  sync ();
+  ops << DL_PICTURE << N(dl->pics) << x << y << alpha;
+  dl->pics << p;
+}
+
+void
+display_list_recorder_rep::draw_scalable (scalable im, SI x, SI y, int alpha) {
+  sync ();
+  ops << DL_SCALABLE << N(dl->ims) << x << y << alpha;
+  dl->ims << im;
+}
+
+/******************************************************************************
+* Shadows are not recorded
+******************************************************************************/
+
+void
+display_list_recorder_rep::fetch (
+  SI x1, SI y1, SI x2, SI y2, renderer ren, SI x, SI y)
+{
+  (void) x1; (void) y1; (void) x2; (void) y2;
+  (void) ren; (void) x; (void) y;
+}
+
+void
+display_list_recorder_rep::new_shadow (renderer& ren) {
+  (void) ren;
+}
+
+void
+display_list_recorder_rep::delete_shadow (renderer& ren) {
+  (void) ren;
+}
+
+void
+display_list_recorder_rep::get_shadow (
+  renderer ren, SI x1, SI y1, SI x2, SI y2)
+{
+  (void) ren; (void) x1; (void) y1; (void) x2; (void) y2;
+}
+
+void
+display_list_recorder_rep::put_shadow (
+  renderer ren, SI x1, SI y1, SI x2, SI y2)
+{
+  (void) ren; (void) x1; (void) y1; (void) x2; (void) y2;
+}
+
+void
+display_list_recorder_rep::apply_shadow (SI x1, SI y1, SI x2, SI y2) {
+  (void) x1; (void) y1; (void) x2; (void) y2;
+}
+
+/******************************************************************************
+* Recording links
+******************************************************************************/
+
+void
+display_list_recorder_rep::anchor (string label, SI x1, SI y1, SI x2, SI y2) {
+  sync ();
+  ops << DL_ANCHOR << N(dl->strs) << x1 << y1 << x2 << y2;
+  dl->strs << label;
+}
+
+void
+display_list_recorder_rep::href (string label, SI x1, SI y1, SI x2, SI y2) {
+  sync ();
+  ops << DL_HREF << N(dl->strs) << x1 << y1 << x2 << y2;
+  dl->strs << label;
+}
+
+void
+display_list_recorder_rep::toc_entry (string kind, string title, SI x, SI y) {
+  sync ();
+  ops << DL_TOC_ENTRY << N(dl->strs) << x << y;
+  dl->strs << kind << title;
+}
+
+/******************************************************************************
+* Replaying display lists
+******************************************************************************/
+
+static inline SI
+clip_min (SI rec, SI base, SI cur) {
+  return rec <= -DL_INFINITY? cur: max (cur, rec + base);
+}
+
+static inline SI
+clip_max (SI rec, SI base, SI cur) {
+  return rec >= DL_INFINITY? cur: min (cur, rec + base);
+}
+
+static inline bool
+hidden (renderer ren, SI x1, SI y1, SI x2, SI y2, SI m) {
+  // is the rectangle outside the clipping region of ren?
+  if (x1 > x2) { SI x= x1; x1= x2; x2= x; }
+  if (y1 > y2) { SI y= y1; y1= y2; y2= y; }
+  if (x1 <= -DL_INFINITY || y1 <= -DL_INFINITY ||
+      x2 >= DL_INFINITY || y2 >= DL_INFINITY) return false;
+  return
+    x2 + m + ren->ox < ren->cx1 || x1 - m + ren->ox > ren->cx2 ||
+    y2 + m + ren->oy < ren->cy1 || y1 - m + ren->oy > ren->cy2;
+}
+
+static inline bool
+shown (renderer ren, array<int>& a, int i, bool cull) {
+  // should the operation at i with a rectangular extent be replayed?
+  SI m= ren->get_pencil ()->get_width () + 2 * ren->pixel;
+  return !cull || !hidden (ren, a[i+1], a[i+2], a[i+3], a[i+4], m);
+}
+
+void
+replay (display_list dl, renderer ren) {
+  SI ox = ren->ox , oy = ren->oy;
+  SI cx1= ren->cx1, cy1= ren->cy1, cx2= ren->cx2, cy2= ren->cy2;
+  SI bx = ox - dl->ox, by= oy - dl->oy;
+  pencil pen0= ren->get_pencil ();
+  brush  fg0 = ren->get_brush ();
+  brush  bg0 = ren->get_background ();
+  bool   clipped= false;
+  bool   cull= true;  // bounding boxes are invalid under transformations
+  static array<int> cs;
+  static array<SI>  xs, ys;
+
+  array<int>& a= dl->ops;
+  int i= 0, n= N(a);
+  while (i < n)
+    switch (a[i]) {
+    case DL_ORIGIN:
+      ren->set_origin (bx + a[i+1], by + a[i+2]);
+      i += 3;
+      break;
+    case DL_CLIP:
+      {
+	SI x1= clip_min (a[i+1], bx, cx1), y1= clip_min (a[i+2], by, cy1);
+	SI x2= clip_max (a[i+3], bx, cx2), y2= clip_max (a[i+4], by, cy2);
+	ren->set_clipping (x1 - ren->ox, y1 - ren->oy,
+			   max (x1, x2) - ren->ox, max (y1, y2) - ren->oy, true);
+	clipped= true;
+	i += 5;
+	break;
+      }
+    case DL_TRANSFORM:
+      if (a[i+1] < 0) ren->reset_transformation ();
+      else ren->set_transformation (dl->frames[a[i+1]]);
+      cull= (a[i+1] < 0);
+      i += 2;
+      break;
+    case DL_PENCIL:
+      ren->set_pencil (a[i+1] < 0? pen0: dl->pens[a[i+1]]);
+      i += 2;
+      break;
+    case DL_BRUSH:
+      ren->set_brush (a[i+1] < 0? fg0: dl->brushes[a[i+1]]);
+      i += 2;
+      break;
+    case DL_BACKGROUND:
+      ren->set_background (a[i+1] < 0? bg0: dl->brushes[a[i+1]]);
+      i += 2;
+      break;
+    case DL_GLYPHS:
+      {
+	font_glyphs fng= dl->fngs[a[i+1]];
+	int j, k= a[i+2];
+	if (cull && hidden (ren, a[i+3], a[i+4], a[i+5], a[i+6], 0)) {
+	  i += 7 + 3*k;
+	  break;
+	}
+	cs->resize (k); xs->resize (k); ys->resize (k);
+	i += 7;
+	for (j=0; j<k; j++, i+=3) {
+	  cs[j]= a[i]; xs[j]= a[i+1]; ys[j]= a[i+2];
+	}
+	ren->draw_glyph_run (cs, fng, xs, ys);
+	break;
+      }
+    case DL_LINE:
+      if (shown (ren, a, i, cull))
+	ren->line (a[i+1], a[i+2], a[i+3], a[i+4]);
+      i += 5;
+      break;
+    case DL_LINES:
+      ren->lines (dl->coords[a[i+1]], dl->coords[a[i+1]+1]);
+      i += 2;
+      break;
+    case DL_CLEAR:
+      if (shown (ren, a, i, cull))
+	ren->clear (a[i+1], a[i+2], a[i+3], a[i+4]);
+      i += 5;
+      break;
+    case DL_CLEAR_PATTERN:
+      if (shown (ren, a, i, cull))
+	ren->clear_pattern (a[i+1], a[i+2], a[i+3], a[i+4]);
+      i += 5;
+      break;
+    case DL_FILL:
+      if (shown (ren, a, i, cull))
+	ren->fill (a[i+1], a[i+2], a[i+3], a[i+4]);
+      i += 5;
+      break;
+    case DL_ARC:
+      if (shown (ren, a, i, cull))
+	ren->arc (a[i+1], a[i+2], a[i+3], a[i+4], a[i+5], a[i+6]);
+      i += 7;
+      break;
+    case DL_FILL_ARC:
+      if (shown (ren, a, i, cull))
+	ren->fill_arc (a[i+1], a[i+2], a[i+3], a[i+4], a[i+5], a[i+6]);
+      i += 7;
+      break;
+    case DL_POLYGON:
+      ren->polygon (dl->coords[a[i+1]], dl->coords[a[i+1]+1], a[i+2] != 0);
+      i += 3;
+      break;
+    case DL_TRIANGLE:
+      ren->draw_triangle (a[i+1], a[i+2], a[i+3], a[i+4], a[i+5], a[i+6]);
+      i += 7;
+      break;
+    case DL_PICTURE:
+      ren->draw_picture (dl->pics[a[i+1]], a[i+2], a[i+3], a[i+4]);
+      i += 5;
+      break;
+    case DL_SCALABLE:
+      ren->draw_scalable (dl->ims[a[i+1]], a[i+2], a[i+3], a[i+4]);
+      i += 5;
+      break;
+    case DL_ANCHOR:
+      ren->anchor (dl->strs[a[i+1]], a[i+2], a[i+3], a[i+4], a[i+5]);
+      i += 6;
+      break;
+    case DL_HREF:
+      ren->href (dl->strs[a[i+1]], a[i+2], a[i+3], a[i+4], a[i+5]);
+      i += 6;
+      break;
+    case DL_TOC_ENTRY:
+      ren->toc_entry (dl->strs[a[i+1]], dl->strs[a[i+1]+1], a[i+2], a[i+3]);
+      i += 4;
+      break;
+    default:
+      FAILED ("invalid display list");
+    }
+
+  ren->set_origin (ox, oy);
+  if (clipped)
+    ren->set_clipping (cx1 - ox, cy1 - oy, cx2 - ox, cy2 - oy, true);
+}
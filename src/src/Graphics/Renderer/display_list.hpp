@@ -0,0 +1,67 @@
+
+/******************************************************************************
+* MODULE     : display_list.hpp
+* DESCRIPTION: flat recordings of rendering operations
+* COPYRIGHT  : (C) 2026  agent
+*******************************************************************************
+* A display list records the calls which are made on a renderer while
+* displaying a box, as a compact array of integer operations with tables
+* for the referenced pencils, brushes, fonts, pictures and frames.
+* Consecutive characters of the same font are recorded as glyph runs,
+* together with a bounding box which is used for skipping the runs
+* outside the clipping region during replays.
+* A display list can be replayed on any renderer with the same
+* resolution and the same position modulo a pixel as the recorder.
+* The memory occupied by all kept display lists is bounded.
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#ifndef DISPLAY_LIST_H
+#define DISPLAY_LIST_H
+#include "renderer.hpp"
+#include "frame.hpp"
+
+class display_list;
+class display_list_rep: public concrete_struct {
+public:
+  SI                  ox, oy;     // initial origin of the recorder
+  SI                  pixel;      // resolution of the recorder
+  double              zoomf;      // zoom factor of the recorder
+  int                 shrinkf;    // shrinking factor of the recorder
+  int                 brushpx;    // pixel size for patterns
+  int                 thicken;    // thickening of characters
+  bool                screen;     // recorded for the screen?
+  bool                printer;    // recorded for a printer?
+  bool                reversed;   // recorded with reversed colors?
+
+  array<int>          ops;        // opcodes followed by their arguments
+  array<font_glyphs>  fngs;       // fonts of the glyph runs
+  array<pencil>       pens;       // pencils
+  array<brush>        brushes;    // brushes and backgrounds
+  array<picture>      pics;       // pictures
+  array<scalable>     ims;        // scalable images
+  array<frame>        frames;     // transformations
+  array<string>       strs;       // labels for anchors, links and toc
+  array<array<SI> >   coords;     // coordinates of lines and polygons
+  int                 bytes;      // memory reserved by keep_display_list
+
+  display_list_rep (renderer ren);
+  ~display_list_rep ();
+  int memory ();
+};
+
+class display_list {
+  CONCRETE_NULL(display_list);
+  display_list (renderer ren);
+};
+CONCRETE_NULL_CODE(display_list);
+
+renderer display_list_recorder (display_list dl, renderer ren);
+bool is_compatible (display_list dl, renderer ren);
+bool keep_display_list (display_list dl);
+void replay (display_list dl, renderer ren);
+
+#endif // defined DISPLAY_LIST_H
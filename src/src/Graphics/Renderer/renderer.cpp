@@ -295,6 +295,21 @@ abs_outer_round (SI& x1, SI& y1, SI& x2, SI& y2) {
 * Default property selection and rendering routines
 ******************************************************************************/
 
+void
+renderer_rep::draw_glyph_run (array<int> cs, font_glyphs fn,
+                              array<SI> xs, array<SI> ys) {
+  int i, n= N(cs);
+  for (i=0; i<n; i++)
+    draw (cs[i], fn, xs[i], ys[i]);
+}
+
+bool
+renderer_rep::has_glyph_runs () {
+  // fonts only build glyph runs for renderers which draw them faster
+  // than the individual glyphs
+  return false;
+}
+
 void
 renderer_rep::draw_triangle (SI x1, SI y1, SI x2, SI y2, SI x3, SI y3) {
   array<SI> x (3), y (3);
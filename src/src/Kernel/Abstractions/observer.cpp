@@ -745,3 +745,13 @@ bool
 observer_rep::get_highlight (int lan, array<int>& cols) {
   (void) lan; (void) cols; return false;
 }
+
+bool
+observer_rep::get_signature (array<int>& sig) {
+  (void) sig; return false;
+}
+
+bool
+observer_rep::get_stamp (int& stamp) {
+  (void) stamp; return false;
+}
@@ -33,6 +33,8 @@ typedef list<int> path;
 #define OBSERVER_UNDO       7
 #define OBSERVER_HIGHLIGHT  8
 #define OBSERVER_WIDGET     9
+#define OBSERVER_SIGNATURE 10
+#define OBSERVER_STAMP     11
 
 /******************************************************************************
 * The observer class
@@ -85,6 +87,8 @@ public:
   virtual bool get_contents (int kind, blackbox& bb);
   virtual bool set_highlight (int lan, int col, int start, int end);
   virtual bool get_highlight (int lan, array<int>& cols);
+  virtual bool get_signature (array<int>& sig);
+  virtual bool get_stamp (int& stamp);
 };
 
 class observer {
@@ -112,6 +116,7 @@ observer tree_position (tree t, int index);
 observer edit_observer (editor_rep* ed);
 observer undo_observer (archiver_rep* arch);
 observer highlight_observer (int lan, array<int> cols);
+observer signature_observer (array<int> sig);
 
 /******************************************************************************
 * Modification routines for trees and other observer-related facilities
@@ -171,6 +176,13 @@ bool has_highlight (tree& ref, int lan);
 array<int> obtain_highlight (tree& ref, int lan);
 void detach_highlight (tree& ref, int lan);
 
+void attach_signature (tree& ref, array<int> sig);
+bool obtain_signature (tree& ref, array<int>& sig);
+
+void attach_stamp (tree& ref, int stamp);
+int  attach_stamp (tree& ref);
+bool obtain_stamp (tree& ref, int& stamp);
+
 void stretched_print (tree t, bool ips= false, int indent= 0);
 
 #endif // defined OBSERVER_H
@@ -686,13 +686,18 @@ tex_font_rep::draw_fixed (renderer ren, string s, SI ox, SI y) {
     }
   }
 
+  bool run= ren->has_glyph_runs ();
+  array<int> cs;
+  array<SI> xs, ys;
   for (i=0; i<m; i++) {
     register int c= buf[i];
     glyph gl= pk->get (c);
     if (is_nil (gl)) continue;
-    ren->draw (c, pk, x, y);
+    if (run) { cs << c; xs << x; ys << y; }
+    else ren->draw (c, pk, x, y);
     x += conv (tfm->w(c)+ ker[i]);
   }
+  if (N(cs) != 0) ren->draw_glyph_run (cs, pk, xs, ys);
   STACK_DELETE_ARRAY (str);
   STACK_DELETE_ARRAY (buf);
   STACK_DELETE_ARRAY (ker);
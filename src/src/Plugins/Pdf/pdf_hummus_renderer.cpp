@@ -218,6 +218,9 @@ public:
   void  set_background (brush b2);
 
   void  draw (int char_code, font_glyphs fn, SI x, SI y);
+  void  draw_glyph_run (array<int> cs, font_glyphs fn,
+                        array<SI> xs, array<SI> ys);
+  bool  has_glyph_runs () { return true; }
   void  line (SI x1, SI y1, SI x2, SI y2);
   void  lines (array<SI> x, array<SI> y);
   void  clear (SI x1, SI y1, SI x2, SI y2);
@@ -1136,6 +1139,30 @@ pdf_hummus_renderer_rep::draw (int ch, font_glyphs fn, SI x, SI y) {
   }
 }
 
+void
+pdf_hummus_renderer_rep::draw_glyph_run (array<int> cs, font_glyphs fn,
+                                         array<SI> xs, array<SI> ys) {
+  int i, n= N(cs);
+  if (n == 0) return;
+  // the first glyph selects the font; when it is an embedded font,
+  // the remaining glyphs are directly queued for the current text object
+  draw (cs[0], fn, xs[0], ys[0]);
+  if (cfid == NULL || cfn != fn->res_name) {
+    for (i=1; i<n; i++)
+      draw (cs[i], fn, xs[i], ys[i]);
+    return;
+  }
+  begin_text ();
+  for (i=1; i<n; i++) {
+    if (cs[i] == 0) draw (cs[i], fn, xs[i], ys[i]);
+    else {
+      glyph gl= fn->get (cs[i]);
+      if (!is_nil (gl))
+        drawn_glyphs << drawn_glyph (ox+xs[i], oy+ys[i], cs[i], gl);
+    }
+  }
+}
+
 /******************************************************************************
  * Graphics primitives
  ******************************************************************************/
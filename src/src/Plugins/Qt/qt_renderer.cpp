@@ -466,23 +466,16 @@ qt_renderer_rep::draw_bis (int c, font_glyphs fng, SI x, SI y) {
   delete im;
 }
 
-void
-qt_renderer_rep::draw (int c, font_glyphs fng, SI x, SI y) {
-  if (pen->get_type () == pencil_brush) {
-    draw_bis (c, fng, x, y);
-    return;
-  }
-
-  // get the pixmap
-  color fgc= pen->get_color ();
+static qt_image
+get_character_image (int c, font_glyphs fng, color fgc, bool rev) {
   basic_character xc (c, fng, std_shrinkf, fgc, 0);
   qt_image mi = character_image [xc];
   if (is_nil(mi)) {
     int r, g, b, a;
     get_rgb (fgc, r, g, b, a);
-    if (get_reverse_colors ()) reverse (r, g, b);
+    if (rev) reverse (r, g, b);
     SI xo, yo;
-    glyph pre_gl= fng->get (c); if (is_nil (pre_gl)) return;
+    glyph pre_gl= fng->get (c); if (is_nil (pre_gl)) return mi;
     glyph gl= shrink (pre_gl, std_shrinkf, std_shrinkf, xo, yo);
     int i, j, w= gl->width, h= gl->height;
 #ifdef QTMPIXMAPS
@@ -529,6 +522,20 @@ qt_renderer_rep::draw (int c, font_glyphs fng, SI x, SI y) {
     // FIXME: we must release the image at some point 
     //        (this should be ok now, see qt_image)
   }
+  return mi;
+}
+
+void
+qt_renderer_rep::draw (int c, font_glyphs fng, SI x, SI y) {
+  if (pen->get_type () == pencil_brush) {
+    draw_bis (c, fng, x, y);
+    return;
+  }
+
+  // get the pixmap
+  color fgc= pen->get_color ();
+  qt_image mi= get_character_image (c, fng, fgc, get_reverse_colors ());
+  if (is_nil (mi)) return;
 
   // draw the character
   //cout << (char)c << ": " << cx1/256 << ","  << cy1/256 << ","  
@@ -536,6 +543,36 @@ qt_renderer_rep::draw (int c, font_glyphs fng, SI x, SI y) {
   draw_clipped (mi->img, mi->w, mi->h, x- mi->xo*std_shrinkf, y+ mi->yo*std_shrinkf);
 }
 
+void
+qt_renderer_rep::draw_glyph_run (array<int> cs, font_glyphs fng,
+                                 array<SI> xs, array<SI> ys) {
+  // the pencil and the colors are the same for all glyphs of the run
+  if (pen->get_type () == pencil_brush) {
+    renderer_rep::draw_glyph_run (cs, fng, xs, ys);
+    return;
+  }
+  color fgc= pen->get_color ();
+  bool  rev= get_reverse_colors ();
+  int i, n= N(cs), prev_c= -1;
+  qt_image mi;
+  painter->setRenderHints (0);
+  for (i=0; i<n; i++) {
+    if (cs[i] != prev_c) {
+      mi= get_character_image (cs[i], fng, fgc, rev);
+      prev_c= cs[i];
+    }
+    if (is_nil (mi)) continue;
+    SI x= xs[i]- mi->xo*std_shrinkf, y= ys[i]+ mi->yo*std_shrinkf;
+    decode (x, y);
+    y--; // top-left origin to bottom-left origin conversion
+#ifdef QTMPIXMAPS
+    painter->drawPixmap (x, y, mi->w, mi->h, *(mi->img));
+#else
+    painter->drawImage (x, y, *(mi->img));
+#endif
+  }
+}
+
 void
 qt_renderer_rep::draw (const QFont& qfn, const QString& qs,
                        SI x, SI y, double zoom) {
@@ -57,6 +57,9 @@ public:
 
   void  draw_bis (int char_code, font_glyphs fn, SI x, SI y);
   void  draw (int char_code, font_glyphs fn, SI x, SI y);
+  void  draw_glyph_run (array<int> cs, font_glyphs fn,
+                        array<SI> xs, array<SI> ys);
+  bool  has_glyph_runs () { return true; }
   void  draw (const QFont& qfn, const QString& s, SI x, SI y, double zoom);
   void  set_pencil (pencil p);
   void  set_brush (brush b);
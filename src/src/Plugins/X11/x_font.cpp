@@ -414,13 +414,18 @@ x_font_rep::get_xpositions (string s, SI* xpos) {
 void
 x_font_rep::draw_fixed (renderer ren, string s, SI x, SI y) {
   if (N(s)!=0) {
-    int i;
-    for (i=0; i<N(s); i++) {
+    int i, n= N(s);
+    bool run= ren->has_glyph_runs ();
+    array<int> cs (run? n: 0);
+    array<SI> xs (run? n: 0), ys (run? n: 0);
+    for (i=0; i<n; i++) {
       QN c= s[i];
-      ren->draw (c, fng, x, y);
+      if (run) { cs[i]= c; xs[i]= x; ys[i]= y; }
+      else ren->draw (c, fng, x, y);
       metric_struct* ex= fnm->get (c);
       x += ex->x2;
     }
+    if (run) ren->draw_glyph_run (cs, fng, xs, ys);
   }
 }
 
@@ -48,6 +48,7 @@
   (get-texmacs-home-path get_texmacs_home_path (url))
   (plugin-list plugin_list (scheme_tree))
   (set-fast-environments set_fast_environments (void bool))
+  (set-display-lists set_display_lists (void bool))
   (font-exists-in-tt? tt_font_exists (bool string))
   (eval-system eval_system (string string))
   (var-eval-system var_eval_system (string string))
@@ -162,8 +163,8 @@
   (image->psdoc image_to_psdoc (string url))
 
   ;; routines for trees
-  (tree->stree tree_to_scheme_tree (scheme_tree tree))
-  (stree->tree scheme_tree_to_tree (tree scheme_tree))
+  (tree->stree tree_to_tmscm_stree (stree tree))
+  (stree->tree tmscm_stree_to_tree (tree stree))
   (tree->string coerce_tree_string (string tree))
   (string->tree coerce_string_tree (tree string))
   (tm->tree tree (tree content))
@@ -434,6 +435,7 @@
 
   (url-complete complete (url url string))
   (url-resolve resolve (url url string))
+  (url-resolve-reset resolve_reset (void))
   (url-resolve-in-path resolve_in_path (url url))
   (url-exists? exists (bool url))
   (url-exists-in-path? exists_in_path (bool url))
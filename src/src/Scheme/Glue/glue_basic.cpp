@@ -328,6 +328,19 @@ tmg_set_fast_environments (tmscm arg1) {
   return TMSCM_UNSPECIFIED;
 }
 
+tmscm
+tmg_set_display_lists (tmscm arg1) {
+  TMSCM_ASSERT_BOOL (arg1, TMSCM_ARG1, "set-display-lists");
+
+  bool in1= tmscm_to_bool (arg1);
+
+  // TMSCM_DEFER_INTS;
+  set_display_lists (in1);
+  // TMSCM_ALLOW_INTS;
+
+  return TMSCM_UNSPECIFIED;
+}
+
 tmscm
 tmg_font_exists_in_ttP (tmscm arg1) {
   TMSCM_ASSERT_STRING (arg1, TMSCM_ARG1, "font-exists-in-tt?");
@@ -1636,20 +1649,20 @@ tmg_tree_2stree (tmscm arg1) {
   tree in1= tmscm_to_tree (arg1);
 
   // TMSCM_DEFER_INTS;
-  scheme_tree out= tree_to_scheme_tree (in1);
+  stree out= tree_to_tmscm_stree (in1);
   // TMSCM_ALLOW_INTS;
 
-  return scheme_tree_to_tmscm (out);
+  return stree_to_tmscm (out);
 }
 
 tmscm
 tmg_stree_2tree (tmscm arg1) {
-  TMSCM_ASSERT_SCHEME_TREE (arg1, TMSCM_ARG1, "stree->tree");
+  TMSCM_ASSERT_STREE (arg1, TMSCM_ARG1, "stree->tree");
 
-  scheme_tree in1= tmscm_to_scheme_tree (arg1);
+  stree in1= tmscm_to_stree (arg1);
 
   // TMSCM_DEFER_INTS;
-  tree out= scheme_tree_to_tree (in1);
+  tree out= tmscm_stree_to_tree (in1);
   // TMSCM_ALLOW_INTS;
 
   return tree_to_tmscm (out);
@@ -5062,6 +5075,15 @@ tmg_url_resolve (tmscm arg1, tmscm arg2) {
   return url_to_tmscm (out);
 }
 
+tmscm
+tmg_url_resolve_reset () {
+  // TMSCM_DEFER_INTS;
+  resolve_reset ();
+  // TMSCM_ALLOW_INTS;
+
+  return TMSCM_UNSPECIFIED;
+}
+
 tmscm
 tmg_url_resolve_in_path (tmscm arg1) {
   TMSCM_ASSERT_URL (arg1, TMSCM_ARG1, "url-resolve-in-path");
@@ -7665,6 +7687,7 @@ initialize_glue_basic () {
   tmscm_install_procedure ("get-texmacs-home-path",  tmg_get_texmacs_home_path, 0, 0, 0);
   tmscm_install_procedure ("plugin-list",  tmg_plugin_list, 0, 0, 0);
   tmscm_install_procedure ("set-fast-environments",  tmg_set_fast_environments, 1, 0, 0);
+  tmscm_install_procedure ("set-display-lists",  tmg_set_display_lists, 1, 0, 0);
   tmscm_install_procedure ("font-exists-in-tt?",  tmg_font_exists_in_ttP, 1, 0, 0);
   tmscm_install_procedure ("eval-system",  tmg_eval_system, 1, 0, 0);
   tmscm_install_procedure ("var-eval-system",  tmg_var_eval_system, 1, 0, 0);
@@ -8015,6 +8038,7 @@ initialize_glue_basic () {
   tmscm_install_procedure ("url-descends?",  tmg_url_descendsP, 2, 0, 0);
   tmscm_install_procedure ("url-complete",  tmg_url_complete, 2, 0, 0);
   tmscm_install_procedure ("url-resolve",  tmg_url_resolve, 2, 0, 0);
+  tmscm_install_procedure ("url-resolve-reset",  tmg_url_resolve_reset, 0, 0, 0);
   tmscm_install_procedure ("url-resolve-in-path",  tmg_url_resolve_in_path, 1, 0, 0);
   tmscm_install_procedure ("url-exists?",  tmg_url_existsP, 1, 0, 0);
   tmscm_install_procedure ("url-exists-in-path?",  tmg_url_exists_in_pathP, 1, 0, 0);
@@ -67,6 +67,11 @@ set_fast_environments (bool b) {
   enable_fastenv= b;
 }
 
+void
+set_display_lists (bool b) {
+  enable_display_lists= b;
+}
+
 void
 win32_display (string s) {
   cout << s;
@@ -376,19 +381,21 @@ tree_remove_node (tree r, int pos) {
 
 #define TMSCM_ASSERT_SCHEME_TREE(p,arg,rout)
 
+static tmscm
+scheme_atom_to_tmscm (string s) {
+  if (s == "#t") return tmscm_true ();
+  if (s == "#f") return tmscm_false ();
+  if (is_int (s)) return int_to_tmscm (as_int (s));
+  if (is_quoted (s))
+    return string_to_tmscm (scm_unquote (s));
+  //if ((N(s)>=2) && (s[0]=='\42') && (s[N(s)-1]=='\42'))
+  //return string_to_tmscm (s (1, N(s)-1));
+  return symbol_to_tmscm (s);
+}
+
 tmscm 
 scheme_tree_to_tmscm (scheme_tree t) {
-  if (is_atomic (t)) {
-    string s= t->label;
-    if (s == "#t") return tmscm_true ();
-    if (s == "#f") return tmscm_false ();
-    if (is_int (s)) return int_to_tmscm (as_int (s));
-    if (is_quoted (s))
-      return string_to_tmscm (scm_unquote (s));
-    //if ((N(s)>=2) && (s[0]=='\42') && (s[N(s)-1]=='\42'))
-    //return string_to_tmscm (s (1, N(s)-1));
-    return symbol_to_tmscm (s);
-  }
+  if (is_atomic (t)) return scheme_atom_to_tmscm (t->label);
   else {
     int i;
     tmscm  p= tmscm_null ();
@@ -417,6 +424,53 @@ tmscm_to_scheme_tree (tmscm  p) {
   return "?";
 }
 
+/******************************************************************************
+* Direct conversions between trees and scheme trees
+******************************************************************************/
+
+// The routines below are equivalent to the compositions of
+// tree_to_scheme_tree with scheme_tree_to_tmscm and of
+// tmscm_to_scheme_tree with scheme_tree_to_tree, but they do not
+// construct intermediate scheme trees nor quote and unquote all strings.
+
+typedef tmscm stree;
+#define TMSCM_ASSERT_STREE(p,arg,rout)
+static inline tmscm stree_to_tmscm (stree p) { return p; }
+static inline stree tmscm_to_stree (tmscm p) { return p; }
+
+static stree
+tree_to_tmscm_stree (tree t) {
+  if (is_atomic (t)) return string_to_tmscm (t->label);
+  int i, n= N(t);
+  tmscm p= tmscm_null ();
+  if (is_func (t, EXPAND) && is_atomic (t[0])) {
+    for (i=n-1; i>=1; i--)
+      p= tmscm_cons (tree_to_tmscm_stree (t[i]), p);
+    return tmscm_cons (scheme_atom_to_tmscm (t[0]->label), p);
+  }
+  for (i=n-1; i>=0; i--)
+    p= tmscm_cons (tree_to_tmscm_stree (t[i]), p);
+  return tmscm_cons (scheme_atom_to_tmscm (as_string (L(t))), p);
+}
+
+static tree
+tmscm_stree_to_tree (stree p) {
+  if (tmscm_is_string (p)) return tmscm_to_string (p);
+  if (tmscm_is_list (p)) {
+    if (tmscm_is_null (p) || tmscm_is_list (tmscm_car (p)) ||
+        tmscm_is_tree (tmscm_car (p)))
+      return scheme_tree_to_tree (tmscm_to_scheme_tree (p));
+    string s= tmscm_to_scheme_tree (tmscm_car (p))->label;
+    tree_label code= make_tree_label (s);
+    tree t (code == UNKNOWN? EXPAND: code);
+    if (code == UNKNOWN) t << tree (s);
+    for (p= tmscm_cdr (p); !tmscm_is_null (p); p= tmscm_cdr (p))
+      t << tmscm_stree_to_tree (tmscm_car (p));
+    return t;
+  }
+  return scheme_tree_to_tree (tmscm_to_scheme_tree (p));
+}
+
 /******************************************************************************
 * Content
 ******************************************************************************/
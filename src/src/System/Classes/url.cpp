@@ -64,6 +64,7 @@
 #include "web_files.hpp"
 #include "file.hpp"
 #include "analyze.hpp"
+#include "hashmap.hpp"
 
 #include <ctype.h>
 
@@ -913,11 +914,25 @@ complete (url u, string filter) {
   return r;
 }
 
+static hashmap<tree,tree> resolve_cache ("");
+
+void
+resolve_reset () {
+  // Resolutions are remembered until files are created, moved or removed
+  // by TeXmacs or by external commands, or until the next event is handled.
+  if (N (resolve_cache) != 0) resolve_cache= hashmap<tree,tree> ("");
+}
+
 url
 resolve (url u, string filter) {
   // This routine does the same thing as complete, but it stops at
   // the first match. It is particularly useful for finding files in paths.
-  return complete (u, filter, true);
+  tree key= tuple (u->t, filter);
+  if (!is_rooted (u)) key << url_pwd ()->t;
+  if (resolve_cache->contains (key)) return as_url (resolve_cache [key]);
+  url r= complete (u, filter, true);
+  resolve_cache (key)= r->t;
+  return r;
   /*
   url res= complete (u, filter, true);
   if (is_none (res))
@@ -146,6 +146,7 @@ bool   is_secure (url u);            // is u secure?
 
 url  complete (url u, string filter= "fr"); // wildcard completion
 url  resolve (url u, string filter= "fr");  // find first match only
+void resolve_reset ();                      // forget previous resolutions
 url  resolve_in_path (url u);               // find file in path
 bool exists (url u);                        // file exists
 bool exists_in_path (url u);                // file exists in path
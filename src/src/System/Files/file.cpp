@@ -114,18 +114,9 @@ load_string (url u, string& s, bool fatal) {
   return err;
 }
 
-bool
-save_string (url u, string s, bool fatal) {
-  if (is_rooted_tmfs (u)) {
-    bool err= save_to_server (u, s);
-    if (err && fatal) {
-      failed_error << "File name= " << as_string (u) << "\n";
-      FAILED ("file not writeable");
-    }
-    return err;
-  }
-
-  // cout << "Save " << u << LF;
+static bool
+write_string (url u, string s, bool fatal, bool append) {
+  // write or append s to the local file u
   url r= u;
   if (!is_rooted_name (r)) r= resolve (r, "");
   bool err= !is_rooted_name (r);
@@ -134,29 +125,35 @@ save_string (url u, string s, bool fatal) {
     {
       c_string _name (name);
 #if defined (OS_WIN32)
-      FILE* fout= _fopen (_name, "wb");
+      FILE* fout= _fopen (_name, append? "ab": "wb");
 #elif defined (__MINGW__) || defined (__MINGW32__)
-      FILE* fout= fopen (_name, "wb");
+      FILE* fout= fopen (_name, append? "ab": "wb");
 #else
-      FILE* fout= fopen (_name, "w");
+      FILE* fout= fopen (_name, append? "a": "w");
 #endif
       if (fout == NULL) {
         err= true;
-        std_warning << "Save error for " << name << ", "
-                    << strerror(errno) << "\n";
+        std_warning << (append? "Append": "Save") << " error for " << name
+                    << ", " << strerror(errno) << "\n";
       }
       if (!err) {
-        int i, n= N(s);
-        for (i=0; i<n; i++)
-          fputc (s[i], fout);
+        int n= N(s);
+        if (n > 0 && fwrite (&(s[0]), 1, n, fout) != (size_t) n) err= true;
         fclose (fout);
       }
     }
+    resolve_reset ();
     // Cache file contents
     bool file_flag= do_cache_file (name);
     bool doc_flag= do_cache_doc (name);
     string cache_type= doc_flag? string ("doc_cache"): string ("file_cache");
-    if (!err && N(s) <= 10000)
+    if (append) {
+      if (file_flag || doc_flag) {
+        cache_reset ("file_cache", name);
+        cache_reset ("doc_cache", name);
+      }
+    }
+    else if (!err && N(s) <= 10000)
       if (file_flag || doc_flag)
 	cache_set (cache_type, name, s);
     declare_out_of_date (url_parent (r));
@@ -170,6 +167,25 @@ save_string (url u, string s, bool fatal) {
   return err;
 }
 
+bool
+save_string (url u, string s, bool fatal) {
+  if (is_rooted_tmfs (u)) {
+    bool err= save_to_server (u, s);
+    if (err && fatal) {
+      failed_error << "File name= " << as_string (u) << "\n";
+      FAILED ("file not writeable");
+    }
+    return err;
+  }
+  // cout << "Save " << u << LF;
+  return write_string (u, s, fatal, false);
+}
+
+bool
+append_string (url u, string s, bool fatal) {
+  return write_string (u, s, fatal, true);
+}
+
 /******************************************************************************
 * Getting attributes of a file
 ******************************************************************************/
@@ -478,6 +494,7 @@ move (url u1, url u2) {
   c_string _u1 (concretize (u1));
   c_string _u2 (concretize (u2));
   (void) rename (_u1, _u2);
+  resolve_reset ();
 }
 
 void
@@ -506,11 +523,13 @@ remove_sub (url u) {
 void
 remove (url u) {
   remove_sub (expand (complete (u)));
+  resolve_reset ();
 }
 
 void
 rmdir (url u) {
   remove_sub (expand (complete (u, "dr")));
+  resolve_reset ();
 }
 
 void
@@ -525,6 +544,7 @@ mkdir (url u) {
     (void) ::mkdir (_u, S_IRWXU + S_IRGRP + S_IROTH);
 #endif
   }
+  resolve_reset ();
 #else
 #if defined(__MINGW__) || defined(__MINGW32__)
   system ("mkdir", u);
@@ -615,11 +635,32 @@ file_completions (url search, url dir) {
 
 /******************************************************************************
 * Grepping of strings with heavy caching
+*******************************************************************************
+* The contents of grepped files are cached in memory up to a total size of
+* GREP_LOAD_MAX bytes. In addition, we maintain a persistent index with the
+* trigram signatures of the lowercased contents of all grepped files in
+* 'grep_cache.scm'. Entries are keyed by file name and invalidated when
+* the modification time of the file changes. Files whose signatures do not
+* contain the searched strings need not be loaded at all.
+*
+* Notice that this is a filter per file rather than an inverted index from
+* trigrams to files: each query still visits the signature of every file,
+* but it no longer needs to load and scan the files themselves. The files
+* to be searched are determined by the search paths anyway, so an index is
+* only consulted for these files. Signatures which are too dense to ever
+* exclude a file are not stored. The decoded signatures, the query results
+* and the expanded search paths are kept in memory, but each of these
+* caches is reset as soon as it exceeds GREP_CACHE_MAX entries.
 ******************************************************************************/
 
+#define GREP_LOAD_MAX 8000000
+#define GREP_CACHE_MAX 1024
+
 hashmap<tree,tree>   grep_cache (url_none () -> t);
 hashmap<tree,string> grep_load_cache ("");
 hashmap<tree,tree>   grep_complete_cache (url_none () -> t);
+static hashmap<tree,array<int> > grep_signature_cache;
+static int           grep_load_size= 0;
 
 static bool
 bad_url (url u) {
@@ -630,17 +671,85 @@ bad_url (url u) {
   else return false;
 }
 
+static string
+signature_as_string (array<int> sig) {
+  string r;
+  for (int i=0; i<N(sig); i++)
+    r << as_hexadecimal (sig[i], 8);
+  return r;
+}
+
+static array<int>
+signature_from_string (string s) {
+  int words= N(s) / 8;
+  if (words == 0 || (words & (words - 1)) != 0) return array<int> ();
+  array<int> sig= trigram_signature (words);
+  for (int i=0; i<N(sig); i++)
+    sig[i]= from_hexadecimal (s (8*i, 8*i+8));
+  return sig;
+}
+
+static void
+grep_index (url u, string s) {
+  int words= 32;
+  while (words < 512 && 64 * words < N(s)) words <<= 1;
+  array<int> sig= trigram_signature (words);
+  trigram_signature_add (sig, locase_all (s));
+  if (trigram_signature_saturated (sig, 1, 2)) sig= array<int> ();
+  string stamp= as_string (last_modified (u));
+  cache_set ("grep_cache.scm", concretize (u),
+             tuple (stamp, signature_as_string (sig)));
+  grep_signature_cache->reset (u->t);
+}
+
 string
 grep_load (url u) {
   if (!grep_load_cache->contains (u->t)) {
     //cout << "Loading " << u << "\n";
     string s;
     if (load_string (u, s, false)) s= "";
+    if (grep_load_size + N(s) > GREP_LOAD_MAX) {
+      grep_load_cache= hashmap<tree,string> ("");
+      grep_load_size= 0;
+    }
     grep_load_cache (u->t)= s;
+    grep_load_size += N(s);
+    grep_index (u, s);
   }
   return grep_load_cache [u->t];
 }
 
+static array<int>
+grep_signature (url u) {
+  // Decoded signature of u, or the empty array if u is not indexed
+  if (!grep_signature_cache->contains (u->t)) {
+    cache_load ("grep_cache.scm");
+    string name= concretize (u);
+    array<int> sig;
+    if (is_cached ("grep_cache.scm", name)) {
+      tree t= cache_get ("grep_cache.scm", name);
+      if (is_tuple (t) && N(t) == 2 &&
+          t[0] == as_string (last_modified (u)))
+        sig= signature_from_string (as_string (t[1]));
+    }
+    if (N (grep_signature_cache) >= GREP_CACHE_MAX)
+      grep_signature_cache= hashmap<tree,array<int> > (array<int> ());
+    grep_signature_cache (u->t)= sig;
+  }
+  return grep_signature_cache [u->t];
+}
+
+static bool
+grep_may_occur (array<string> a, url u) {
+  // Check using the index whether all strings in a might occur in u
+  array<int> sig= grep_signature (u);
+  if (N(sig) == 0) return true;
+  for (int i=0; i<N(a); i++)
+    if (!trigram_signature_contains (sig, locase_all (a[i])))
+      return false;
+  return true;
+}
+
 url
 grep_sub (string what, url u) {
   if (is_or (u))
@@ -648,6 +757,9 @@ grep_sub (string what, url u) {
   else if (bad_url (u))
     return url_none ();
   else {
+    array<string> a;
+    a << what;
+    if (!grep_may_occur (a, u)) return url_none ();
     string contents= grep_load (u);
     if (occurs (what, contents)) return u;
     else return url_none ();
@@ -658,10 +770,16 @@ url
 grep (string what, url u) {
   tree key= tuple (what, u->t);
   if (!grep_cache->contains (key)) {
+    bench_start ("grep");
+    if (N (grep_cache) >= GREP_CACHE_MAX)
+      grep_cache= hashmap<tree,tree> (url_none () -> t);
+    if (N (grep_complete_cache) >= GREP_CACHE_MAX)
+      grep_complete_cache= hashmap<tree,tree> (url_none () -> t);
     if (!grep_complete_cache->contains (u->t))
       grep_complete_cache (u->t)= expand (complete (u)) -> t;
     url found= grep_sub (what, as_url (grep_complete_cache [u->t]));
     grep_cache (key)= found->t;
+    bench_cumul ("grep");
   }
   return as_url (grep_cache [key]);
 }
@@ -729,6 +847,7 @@ compute_score (string what, string in, array<int> pos, string suf) {
 
 int
 search_score (url u, array<string> a) {
+  if (!grep_may_occur (a, u)) return 0;
   string in = grep_load (u);
   if (N(in) == 0) return 0;
   in= locase_all (in);
@@ -17,6 +17,7 @@
 
 bool load_string (url file_name, string& s, bool fatal);
 bool save_string (url file_name, string s, bool fatal=false);
+bool append_string (url file_name, string s, bool fatal=false);
 
 bool is_of_type (url name, string filter);
 bool is_regular (url name);
@@ -13,6 +13,7 @@
 #include "hyphenate.hpp"
 #include "analyze.hpp"
 #include "converter.hpp"
+#include "iterator.hpp"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -20,6 +21,7 @@
 
 #define MAX_SEARCH 10
 #define MAX_BUFFER_SIZE 256
+#define MAX_CACHED_WORDS 65536
 
 /*
 static bool
@@ -96,6 +98,79 @@ load_hyphen_tables (string file_name,
   }
 }
 
+/******************************************************************************
+* Compilation of the patterns into a packed trie
+******************************************************************************/
+
+hyphenator_rep::hyphenator_rep (hashmap<string,string> patterns,
+                                hashmap<string,string> hyphenations2,
+                                bool utf8b):
+  hyphenations (hyphenations2), utf8 (utf8b), cache (array<int> ())
+{
+  // Build the trie, indexing edges by node and character
+  hashmap<int,int> edges (-1);
+  values << -1;
+  iterator<string> it= iterate (patterns);
+  while (it->busy ()) {
+    string key= it->next (), pat= patterns [key];
+    int i, j, k, node= 0;
+    for (i=0; i<N(key); i++) {
+      int e= (node << 8) + ((int) (unsigned char) key[i]);
+      if (!edges->contains (e)) {
+        edges (e)= N(values);
+        values << -1;
+      }
+      node= edges [e];
+    }
+    values[node]= N(digits);
+    for (j=0, k=0; j<=N(key); j++, k++) {
+      int m= 0;
+      if ((k<N(pat)) && (pat[k]>='0') && (pat[k]<='9')) {
+        m=((int) pat[k])-((int) '0');
+        k++;
+      }
+      digits << m;
+    }
+  }
+
+  // Pack the edges leaving each node, sorted by character
+  int i, n= N(values);
+  start= array<int> (n+1);
+  for (i=0; i<=n; i++) start[i]= 0;
+  iterator<int> jt= iterate (edges);
+  while (jt->busy ()) start[(jt->next () >> 8) + 1]++;
+  for (i=0; i<n; i++) start[i+1] += start[i];
+  array<int> fill= copy (start);
+  label = string (N(edges));
+  target= array<int> (N(edges));
+  jt= iterate (edges);
+  while (jt->busy ()) {
+    int e= jt->next (), node= e >> 8, c= e & 255, j= fill[node]++;
+    for (; j > start[node] && ((int) (unsigned char) label[j-1]) > c; j--) {
+      label [j]= label [j-1];
+      target[j]= target[j-1];
+    }
+    label [j]= (char) c;
+    target[j]= edges [e];
+  }
+}
+
+hyphenator::hyphenator (hashmap<string,string> patterns,
+                        hashmap<string,string> hyphenations, bool utf8):
+  rep (tm_new<hyphenator_rep> (patterns, hyphenations, utf8)) {}
+
+hyphenator
+load_hyphenator (string file_name, bool utf8) {
+  hashmap<string,string> patterns ("?");
+  hashmap<string,string> hyphenations ("?");
+  load_hyphen_tables (file_name, patterns, hyphenations, !utf8);
+  return hyphenator (patterns, hyphenations, utf8);
+}
+
+/******************************************************************************
+* Hyphenation of words
+******************************************************************************/
+
 static string
 lower_case (string s) {
   int i;
@@ -108,13 +183,6 @@ lower_case (string s) {
   return r;
 }
 
-array<int>
-get_hyphens (string s,
-             hashmap<string,string> patterns,
-             hashmap<string,string> hyphenations) {
-  return get_hyphens (s, patterns, hyphenations, false);
-}
-
 void
 goto_next_char (string s, int &i, bool utf8) {
   if (utf8) decode_from_utf8 (s, i);
@@ -141,16 +209,13 @@ str_length (string s, bool utf8) {
   else return N(s);
 }
 
-array<int>
-get_hyphens (string s,
-             hashmap<string,string> patterns,
-             hashmap<string,string> hyphenations, bool utf8) {
-  ASSERT (N(s) != 0, "hyphenation of empty string");
-
+static array<int>
+compute_hyphens (string s, hyphenator hyph) {
+  bool utf8= hyph->utf8;
   if (utf8) s= cork_to_utf8 (s);
 
-  if (hyphenations->contains (s)) {
-    string h= hyphenations [s];
+  if (hyph->hyphenations->contains (s)) {
+    string h= hyph->hyphenations [s];
     array<int> penalty (str_length (s, utf8)-1);
     int i=0, j=0;
     while (h[j] == '-') j++;
@@ -170,23 +235,19 @@ get_hyphens (string s,
   else {
     s= "." * lower_case (s) * ".";
     // cout << s << "\n";
-    int i, j, k, l, m, len;
+    int i, j, l, m, len, node, n= N(s);
     array<int> T (str_length (s, utf8)+1);
     for (i=0; i<N(T); i++) T[i]=0;
-    for (len=1; len < MAX_SEARCH; len++)
-      for (i=0, l=0; i<N(s) - len; goto_next_char (s, i, utf8), l++) {
-        string r= patterns [s (i, i+len)];
-        if (!(r == "?")) {
-          // cout << "  " << s (i, i+len) << " => " << r << "\n";
-          for (j=0, k=0; j<=len; j++, k++) {
-            if ((k<N(r)) && (r[k]>='0') && (r[k]<='9')) {
-              m=((int) r[k])-((int) '0');
-              k++;
-            }
-            else m=0;
+    for (i=0, l=0; i < n-1; goto_next_char (s, i, utf8), l++)
+      for (len=1, node=0; len < MAX_SEARCH && i+len < n; len++) {
+        node= hyph->next (node, s[i+len-1]);
+        if (node < 0) break;
+        int v= hyph->values[node];
+        if (v >= 0)
+          for (j=0; j<=len; j++) {
+            m= hyph->digits[v+j];
             if (m>T[l+j]) T[l+j]=m;
           }
-        }
       }
 
     array<int> penalty (N(T)-4);
@@ -200,6 +261,17 @@ get_hyphens (string s,
   }
 }
 
+array<int>
+get_hyphens (string s, hyphenator h) {
+  ASSERT (N(s) != 0, "hyphenation of empty string");
+  if (h->cache->contains (s)) return h->cache [s];
+  array<int> penalty= compute_hyphens (s, h);
+  if (N(h->cache) >= MAX_CACHED_WORDS)
+    h->cache= hashmap<string,array<int> > (array<int> ());
+  h->cache (s)= penalty;
+  return penalty;
+}
+
 void
 std_hyphenate (string s, int after, string& left, string& right, int penalty) {
   std_hyphenate (s, after, left, right, penalty, false);
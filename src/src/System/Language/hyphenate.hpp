@@ -13,15 +13,57 @@
 #define HYPHENATE_H
 #include "language.hpp"
 
+/******************************************************************************
+* Hyphenation patterns are compiled into a packed trie: the edges leaving
+* a node are stored consecutively, sorted by character, starting at
+* start[node]. Nodes which terminate a pattern point to the inter-letter
+* values of the pattern in the digits array. Hyphenations of words are
+* memoized, since the same words tend to be hyphenated over and over again.
+******************************************************************************/
+
+class hyphenator;
+class hyphenator_rep: concrete_struct {
+public:
+  hashmap<string,string>      hyphenations; // explicit hyphenations
+  bool                        utf8;         // utf8 or cork encoding?
+  array<int>                  start;        // first edge of each node
+  string                      label;        // characters along the edges
+  array<int>                  target;       // targets of the edges
+  array<int>                  values;       // offsets in digits or -1
+  array<int>                  digits;       // inter-letter pattern values
+  hashmap<string,array<int> > cache;        // memoized hyphenations
+
+  hyphenator_rep (hashmap<string,string> patterns,
+                  hashmap<string,string> hyphenations, bool utf8);
+  inline int next (int node, char c);
+
+  friend class hyphenator;
+};
+
+class hyphenator {
+  CONCRETE(hyphenator);
+  hyphenator (hashmap<string,string> patterns,
+              hashmap<string,string> hyphenations, bool utf8= false);
+};
+CONCRETE_CODE(hyphenator);
+
+inline int
+hyphenator_rep::next (int node, char c) {
+  int i= start[node], j= start[node+1];
+  while (i < j) {
+    int m= (i + j) >> 1;
+    if (((unsigned char) label[m]) < ((unsigned char) c)) i= m+1;
+    else j= m;
+  }
+  if (i < start[node+1] && label[i] == c) return target[i];
+  return -1;
+}
+
 void load_hyphen_tables (string language_name,
                          hashmap<string,string>& patterns,
                          hashmap<string,string>& hyphenations, bool toCork);
-array<int> get_hyphens (string s,
-                        hashmap<string,string> patterns,
-                        hashmap<string,string> hyphenations);
-array<int> get_hyphens (string s,
-                        hashmap<string,string> patterns,
-                        hashmap<string,string> hyphenations, bool utf8);
+hyphenator load_hyphenator (string language_name, bool utf8);
+array<int> get_hyphens (string s, hyphenator h);
 void std_hyphenate (string s, int after, string& left, string& right, int pen);
 void std_hyphenate (string s, int after, string& left, string& right, int pen,
                     bool utf8);
@@ -12,6 +12,7 @@
 #include "packrat_grammar.hpp"
 #include "analyze.hpp"
 #include "iterator.hpp"
+#include "merge_sort.hpp"
 
 tree                 packrat_uninit (UNINIT);
 int                  packrat_nr_tokens= 256;
@@ -172,7 +173,8 @@ singleton (C c) {
 packrat_grammar_rep::packrat_grammar_rep (string s):
   rep<packrat_grammar> (s),
   grammar (singleton (PACKRAT_TM_FAIL)),
-  productions (packrat_uninit)
+  productions (packrat_uninit),
+  revision (0), compiled (-1)
 {
   grammar (PACKRAT_TM_OPEN)= singleton (PACKRAT_TM_OPEN);
   grammar (PACKRAT_TM_ANY )= singleton (PACKRAT_TM_ANY );
@@ -311,6 +313,7 @@ packrat_grammar_rep::define (string s, tree t) {
     array<C> def= define (t);
     grammar (sym)= def;
   }
+  revision++;
 }
 
 void
@@ -320,6 +323,142 @@ packrat_grammar_rep::set_property (string s, string var, string val) {
   C prop= encode_symbol (compound ("property", var));
   D key = (((D) prop) << 32) + ((D) (sym ^ prop));
   properties (key)= val;
+  revision++;
+}
+
+/******************************************************************************
+* Compilation of grammars
+*******************************************************************************
+* Before parsing, the grammar is compiled into a form which is more suitable
+* for fast parsing. Definitions are stored in an array indexed by symbol
+* number and we compute for each symbol whether it may match the empty
+* string and which tokens may start a non empty match. This allows the
+* parser to reject symbols early, without memoizing the failure.
+******************************************************************************/
+
+#define PACKRAT_MAX_FIRST 4096
+
+static void
+first_of (C sym, packrat_grammar_rep* gr, array<hashset<C> >& sets,
+          bool& null, bool& wild, hashset<C>& h)
+{
+  if (sym < PACKRAT_OR) h->insert (sym);
+  else if (sym >= PACKRAT_SYMBOLS) {
+    int i= sym - PACKRAT_SYMBOLS;
+    if (i >= N(sets)) { null= wild= true; return; }
+    null= null || gr->nullable[i];
+    wild= wild || gr->wildcard[i];
+    if (!wild) {
+      iterator<C> it= iterate (sets[i]);
+      while (it->busy ()) h->insert (it->next ());
+    }
+  }
+  else switch (sym) {
+    case PACKRAT_TM_OPEN:
+    case PACKRAT_TM_CHAR:
+      wild= true;
+      break;
+    case PACKRAT_TM_ANY:
+    case PACKRAT_TM_ARGS:
+    case PACKRAT_TM_LEAF:
+      null= wild= true;
+      break;
+    case PACKRAT_TM_CURSOR:
+      null= true;
+      break;
+    case PACKRAT_TM_FAIL:
+      break;
+    default:
+      null= wild= true;
+      break;
+    }
+}
+
+static void
+first_of (array<C> def, packrat_grammar_rep* gr, array<hashset<C> >& sets,
+          bool& null, bool& wild, hashset<C>& h)
+{
+  if (N(def) == 0) { null= wild= true; return; }
+  switch (def[0]) {
+  case PACKRAT_OR:
+    for (int i=1; i<N(def); i++)
+      first_of (def[i], gr, sets, null, wild, h);
+    break;
+  case PACKRAT_CONCAT:
+    for (int i=1; i<N(def); i++) {
+      bool sub_null= false;
+      first_of (def[i], gr, sets, sub_null, wild, h);
+      if (!sub_null) return;
+    }
+    null= true;
+    break;
+  case PACKRAT_WHILE:
+    first_of (def[1], gr, sets, null, wild, h);
+    null= true;
+    break;
+  case PACKRAT_REPEAT:
+  case PACKRAT_EXCEPT:
+    first_of (def[1], gr, sets, null, wild, h);
+    break;
+  case PACKRAT_RANGE:
+    if (def[2] - def[1] >= PACKRAT_MAX_FIRST) wild= true;
+    else for (C c= def[1]; c <= def[2]; c++) h->insert (c);
+    break;
+  case PACKRAT_NOT:
+    null= true;
+    break;
+  default:
+    first_of (def[0], gr, sets, null, wild, h);
+    break;
+  }
+}
+
+void
+packrat_grammar_rep::compile () {
+  if (compiled == revision) return;
+  int i, n= packrat_nr_symbols;
+  code    = array<array<C> > (n);
+  nullable= array<bool> (n);
+  wildcard= array<bool> (n);
+  first   = array<array<C> > (n);
+
+  for (i=0; i<n; i++) {
+    code[i]= grammar [i + PACKRAT_SYMBOLS];
+    nullable[i]= false;
+    wildcard[i]= false;
+  }
+
+  // Compute first tokens and nullability as the least fixed point
+  array<hashset<C> > sets (n);
+  bool changed= true;
+  while (changed) {
+    changed= false;
+    for (i=0; i<n; i++) {
+      if (wildcard[i] && nullable[i]) continue;
+      bool null= nullable[i], wild= wildcard[i];
+      hashset<C> h= sets[i];
+      int old_size= N(h);
+      first_of (code[i], this, sets, null, wild, h);
+      if (N(h) > PACKRAT_MAX_FIRST) wild= true;
+      if (wild) h= hashset<C> ();
+      if (null != nullable[i] || wild != wildcard[i] || N(h) != old_size) {
+        nullable[i]= null;
+        wildcard[i]= wild;
+        sets[i]= h;
+        changed= true;
+      }
+    }
+  }
+
+  // Sorted arrays for fast membership tests during parsing
+  for (i=0; i<n; i++) {
+    array<C> a;
+    iterator<C> it= iterate (sets[i]);
+    while (it->busy ()) a << it->next ();
+    merge_sort (a);
+    first[i]= a;
+  }
+  compiled= revision;
 }
 
 /******************************************************************************
@@ -405,6 +544,7 @@ packrat_inherit (string lan, string from) {
     //cout << "Inherit " << p << " -> " << inh->properties (p) << LF;
     gr->properties (p)= inh->properties (p);
   }
+  gr->revision++;
 }
 
 int
@@ -74,9 +74,17 @@ struct packrat_grammar_rep: rep<packrat_grammar> {
   hashmap<C,tree>        productions;
   hashmap<D,string>      properties;
 
+  int                    revision;  // incremented upon each modification
+  int                    compiled;  // revision of the compiled grammar
+  array<array<C> >       code;      // definitions indexed by symbol number
+  array<bool>            nullable;  // may symbols match the empty string?
+  array<bool>            wildcard;  // may symbols start with any token?
+  array<array<C> >       first;     // sorted sets of possible first tokens
+
   packrat_grammar_rep (string s);
 
   void accelerate (array<C>& def);
+  void compile ();
   array<C> define (tree t);
   void define (string s, tree t);  
   void set_property (string s, string var, string val);
@@ -13,6 +13,8 @@
 #include "analyze.hpp"
 #include "drd_std.hpp"
 #include "language.hpp" //(en|de)code_color
+#include "iterator.hpp"
+#include "timer.hpp"
 
 extern tree the_et;
 bool packrat_invalid_colors= false;
@@ -35,20 +37,84 @@ packrat_parser_rep::packrat_parser_rep (packrat_grammar gr):
   current_cursor (-1),
   current_input (),
   current_cache (PACKRAT_UNDEFINED),
-  current_production (packrat_uninit) {}
+  current_extent (0),
+  current_examined (0),
+  current_production (packrat_uninit)
+{
+  gr->compile ();
+  code    = gr->code;
+  nullable= gr->nullable;
+  wildcard= gr->wildcard;
+  first   = gr->first;
+}
+
+/******************************************************************************
+* Cache with the most recently used parsers
+*******************************************************************************
+* We keep the parsers for the PACKRAT_PARSERS most recently parsed inputs,
+* so that alternating between several inputs or languages does not throw
+* away the memoized parse results. When a new input is parsed, we update
+* the parser of the most similar cached input of the same language.
+******************************************************************************/
+
+#define PACKRAT_PARSERS 8
+
+static int
+packrat_similarity (tree t1, tree t2) {
+  // number of identical children at the start and the end of t1 and t2
+  if (is_atomic (t1) || is_atomic (t2) || L(t1) != L(t2)) return 0;
+  int n1= N(t1), n2= N(t2), a= 0, b= 0;
+  while (a < n1 && a < n2 && t1[a] == t2[a]) a++;
+  while (b < n1 - a && b < n2 - a && t1[n1-1-b] == t2[n2-1-b]) b++;
+  return a + b;
+}
 
 packrat_parser
 make_packrat_parser (string lan, tree in) {
-  static string         last_lan   = "";
-  static tree           last_in    = "";
-  static packrat_parser last_par;
-  if (lan != last_lan || in != last_in) {
-    packrat_grammar gr= find_packrat_grammar (lan);
-    last_lan   = lan;
-    last_in    = copy (in);
-    last_par   = packrat_parser (gr, in);
+  static array<string>         last_lan;
+  static array<tree>           last_in;
+  static array<int>            last_rev;
+  static array<packrat_parser> last_par;
+  packrat_grammar gr= find_packrat_grammar (lan);
+  int i, n= N(last_par), hit= -1, best= -1, best_sim= 0;
+  for (i=0; i<n; i++)
+    if (last_lan[i] == lan && last_rev[i] == gr->revision) {
+      if (last_in[i] == in) { hit= i; break; }
+      int sim= packrat_similarity (last_in[i], in);
+      if (sim > best_sim) { best= i; best_sim= sim; }
+    }
+  if (hit < 0) {
+    tree cin= copy (in);
+    if (best >= 0) {
+      hit= best;
+      last_in[hit]= cin;
+      last_par[hit]->update_input (cin);
+    }
+    else {
+      if (n < PACKRAT_PARSERS) {
+        last_lan << string (""); last_in << tree (""); last_rev << -1;
+        last_par << packrat_parser (); n++;
+      }
+      hit= n-1;
+      last_lan[hit]= lan;
+      last_in [hit]= cin;
+      last_rev[hit]= gr->revision;
+      last_par[hit]= packrat_parser (gr, cin);
+    }
   }
-  return last_par;
+  packrat_parser par= last_par[hit];
+  tree           pin= last_in[hit];
+  for (i=hit; i>0; i--) {
+    last_lan[i]= last_lan[i-1];
+    last_in [i]= last_in [i-1];
+    last_rev[i]= last_rev[i-1];
+    last_par[i]= last_par[i-1];
+  }
+  last_lan[0]= lan;
+  last_in [0]= pin;
+  last_rev[0]= gr->revision;
+  last_par[0]= par;
+  return par;
 }
 
 packrat_parser
@@ -56,12 +122,15 @@ make_packrat_parser (string lan, tree in, path in_pos) {
   static string         last_lan   = "";
   static tree           last_in    = "";
   static path           last_in_pos= path ();
+  static int            last_rev   = -1;
   static packrat_parser last_par;
-  if (lan != last_lan || in != last_in || in_pos != last_in_pos) {
-    packrat_grammar gr= find_packrat_grammar (lan);
+  packrat_grammar gr= find_packrat_grammar (lan);
+  if (lan != last_lan || in != last_in || in_pos != last_in_pos ||
+      gr->revision != last_rev) {
     last_lan   = lan;
     last_in    = copy (in);
-    last_in_pos= copy (last_in_pos);
+    last_in_pos= copy (in_pos);
+    last_rev   = gr->revision;
     last_par   = packrat_parser (gr, in, in_pos);
   }
   return last_par;
@@ -81,6 +150,140 @@ packrat_parser_rep::set_input (tree t) {
   current_input= encode_tokens (current_string);
 }
 
+static path
+shift_path (path p, int j, int d) {
+  // shift the paths to the children starting at j by d
+  if (is_nil (p) || p->item < j) return p;
+  return path (p->item + d, p->next);
+}
+
+bool
+packrat_parser_rep::update_serialization (tree t) {
+  // Serialize t, while only serializing the children of t
+  // which differ from the children of the current input
+  tree old= current_tree;
+  if (is_atomic (t) || is_atomic (old) || L(t) != L(old)) return false;
+  if (!is_concat (t) && !is_document (t)) return false;
+  int n1= N(old), n2= N(t), a= 0, b= 0;
+  while (a < n1 && a < n2 && old[a] == t[a]) a++;
+  while (b < n1 - a && b < n2 - a && old[n1-1-b] == t[n2-1-b]) b++;
+  string old_string= current_string;
+  int s0= (a < n1? current_start [path (a)]: N(old_string));
+  int s1= (b > 0 ? current_start [path (n1-b)]: N(old_string));
+  if (s0 < 0 || s1 < s0) return false;
+  C k0= encode_string_position (s0);
+  C k1= encode_string_position (s1);
+
+  hashmap<path,int> old_start   = current_start;
+  hashmap<path,int> old_end     = current_end;
+  hashmap<path,int> old_path_pos= current_path_pos;
+  current_start   = hashmap<path,int> (-1);
+  current_end     = hashmap<path,int> (-1);
+  current_path_pos= hashmap<path,int> (-1);
+  current_pos_path= hashmap<int,path> (-1);
+  current_tree    = t;
+  current_string  = old_string (0, s0);
+  for (int i=a; i<n2-b; i++) {
+    serialize (t[i], path (i));
+    if (is_document (t)) current_string << "\n";
+  }
+  string middle= current_string (s0, N(current_string));
+  int delta= N(current_string) - s1, j= n1 - b, d= n2 - n1;
+  current_string << old_string (s1, N(old_string));
+
+  iterator<path> it= iterate (old_start);
+  while (it->busy ()) {
+    path p= it->next ();
+    if (is_nil (p)) continue;
+    if (p->item < a) current_start (p)= old_start [p];
+    else if (p->item >= j)
+      current_start (shift_path (p, j, d))= old_start [p] + delta;
+  }
+  it= iterate (old_end);
+  while (it->busy ()) {
+    path p= it->next ();
+    if (is_nil (p)) continue;
+    if (p->item < a) current_end (p)= old_end [p];
+    else if (p->item >= j)
+      current_end (shift_path (p, j, d))= old_end [p] + delta;
+  }
+  it= iterate (old_path_pos);
+  while (it->busy ()) {
+    path p= it->next ();
+    if (is_nil (p)) continue;
+    int pos= old_path_pos [p];
+    if (p->item < a) {
+      current_path_pos (p)= pos;
+      current_pos_path (pos)= p;
+    }
+    else if (p->item >= j) {
+      path q= shift_path (p, j, d);
+      current_path_pos (q)= pos + delta;
+      current_pos_path (pos + delta)= q;
+    }
+  }
+  current_start (path ())= 0;
+  current_end (path ())= N(current_string);
+
+  array<C> mid= encode_tokens (middle);
+  current_input= append (append (range (current_input, 0, k0), mid),
+                         range (current_input, k1, N(current_input)));
+  return true;
+}
+
+void
+packrat_parser_rep::update_input (tree t) {
+  // Replace the input by t, while keeping all memoized parse results
+  // which did not examine the modified part of the input
+  bench_start ("packrat update");
+  array<C> old_input= current_input;
+  if (!update_serialization (t)) {
+    current_start   = hashmap<path,int> (-1);
+    current_end     = hashmap<path,int> (-1);
+    current_path_pos= hashmap<path,int> (-1);
+    current_pos_path= hashmap<int,path> (-1);
+    set_input (t);
+  }
+  current_production= hashmap<D,tree> (packrat_uninit);
+
+  int n1= N(old_input), n2= N(current_input), a= 0, b= 0;
+  while (a < n1 && a < n2 && old_input[a] == current_input[a]) a++;
+  while (b < n1 - a && b < n2 - a &&
+         old_input[n1-1-b] == current_input[n2-1-b]) b++;
+  C old_end= n1 - b, delta= n2 - n1;
+
+  hashmap<D,C> old_cache = current_cache;
+  hashmap<D,C> old_extent= current_extent;
+  current_cache = hashmap<D,C> (PACKRAT_UNDEFINED);
+  current_extent= hashmap<D,C> (0);
+  int kept= 0, shifted= 0, dropped= 0;
+  iterator<D> it= iterate (old_cache);
+  while (it->busy ()) {
+    D key= it->next ();
+    C sym= (C) (key >> 32);
+    C pos= ((C) (key - (((D) sym) << 32))) ^ sym;
+    C im = old_cache [key];
+    C ext= old_extent [key];
+    if (ext <= a) {
+      current_cache (key)= im;
+      current_extent (key)= ext;
+      kept++;
+    }
+    else if (pos >= old_end) {
+      D nkey= (((D) sym) << 32) + ((D) (sym ^ (pos + delta)));
+      current_cache (nkey)= (im == PACKRAT_FAILED? im: im + delta);
+      current_extent (nkey)= ext + delta;
+      shifted++;
+    }
+    else dropped++;
+  }
+  bench_cumul ("packrat update");
+  if (DEBUG_PACKRAT)
+    debug_packrat << "Update input, modified " << a << " -- " << old_end
+                  << " -> " << (old_end + delta) << ", kept " << kept
+                  << ", shifted " << shifted << ", dropped " << dropped << LF;
+}
+
 void
 packrat_parser_rep::set_cursor (path p) {
   if (is_nil (p)) current_cursor= -1;
@@ -178,20 +381,50 @@ starts (tree t, string s) {
   return is_atomic (t) && starts (t->label, s);
 }
 
+static inline void
+examine (C& examined, C pos) {
+  if (pos + 1 > examined) examined= pos + 1;
+}
+
+bool
+packrat_parser_rep::may_start (C sym, C pos) {
+  // Quick rejection of symbols based on the compiled grammar
+  int i= sym - PACKRAT_SYMBOLS;
+  if (i < 0 || i >= N(code) || nullable[i]) return true;
+  examine (current_examined, pos);
+  if (pos >= N (current_input)) return false;
+  if (wildcard[i]) return true;
+  array<C>& a= first[i];
+  C c= current_input[pos];
+  int lo= 0, hi= N(a);
+  while (lo < hi) {
+    int mid= (lo + hi) >> 1;
+    if (a[mid] < c) lo= mid + 1;
+    else hi= mid;
+  }
+  return lo < N(a) && a[lo] == c;
+}
+
 C
 packrat_parser_rep::parse (C sym, C pos) {
+  if (!may_start (sym, pos)) return PACKRAT_FAILED;
   D key= (((D) sym) << 32) + ((D) (sym^pos));
   C im = current_cache [key];
   if (im != PACKRAT_UNDEFINED) {
     //cout << "Cached " << sym << " at " << pos << " -> " << im << LF;
+    C ext= current_extent [key];
+    if (ext > current_examined) current_examined= ext;
     return im;
   }
   current_cache (key)= PACKRAT_FAILED;
+  C saved_examined= current_examined;
+  current_examined= pos;
   if (DEBUG_PACKRAT)
     debug_packrat << "Parse " << packrat_decode[sym]
                   << " at " << pos << INDENT << LF;
   if (sym >= PACKRAT_TM_OPEN) {
-    array<C> inst= grammar [sym];
+    int      nr  = sym - PACKRAT_SYMBOLS;
+    array<C> inst= (nr >= 0 && nr < N(code)? code[nr]: grammar [sym]);
     //cout << "Parse " << inst << " at " << pos << LF;
     switch (inst[0]) {
     case PACKRAT_OR:
@@ -226,6 +459,7 @@ packrat_parser_rep::parse (C sym, C pos) {
 	}
       break;
     case PACKRAT_RANGE:
+      examine (current_examined, pos);
       if (pos < N (current_input) &&
 	  current_input [pos] >= inst[1] &&
 	  current_input [pos] <= inst[2])
@@ -243,6 +477,7 @@ packrat_parser_rep::parse (C sym, C pos) {
 	  im= PACKRAT_FAILED;
       break;
     case PACKRAT_TM_OPEN:
+      examine (current_examined, pos);
       if (pos < N (current_input) &&
 	  starts (packrat_decode[current_input[pos]], "<\\"))
 	im= pos + 1;
@@ -265,9 +500,12 @@ packrat_parser_rep::parse (C sym, C pos) {
       break;
     case PACKRAT_TM_ARGS:
       im= parse (PACKRAT_TM_ANY, pos);
-      while (im < N (current_input))
+      while (im < N (current_input)) {
+        examine (current_examined, im);
 	if (current_input[im] != encode_token ("<|>")) break;
 	else im= parse (PACKRAT_TM_ANY, im + 1);
+      }
+      if (im >= 0) examine (current_examined, im);
       break;
     case PACKRAT_TM_LEAF:
       im= pos;
@@ -276,8 +514,10 @@ packrat_parser_rep::parse (C sym, C pos) {
 	if (starts (t, "<\\") || t == "<|>" || t == "</>") break;
 	else im++;
       }
+      examine (current_examined, im);
       break;
     case PACKRAT_TM_CHAR:
+      examine (current_examined, pos);
       if (pos >= N (current_input)) im= PACKRAT_FAILED;
       else {
 	tree t= packrat_decode[current_input[pos]];
@@ -286,6 +526,7 @@ packrat_parser_rep::parse (C sym, C pos) {
       }
       break;
     case PACKRAT_TM_CURSOR:
+      examine (current_examined, pos);
       if (pos == current_cursor) im= pos;
       else im= PACKRAT_FAILED;
       break;
@@ -298,10 +539,13 @@ packrat_parser_rep::parse (C sym, C pos) {
     }
   }
   else {
+    examine (current_examined, pos);
     if (pos < N (current_input) && current_input[pos] == sym) im= pos + 1;
     else im= PACKRAT_FAILED;
   }
   current_cache (key)= im;
+  current_extent (key)= current_examined;
+  if (saved_examined > current_examined) current_examined= saved_examined;
   if (DEBUG_PACKRAT)
     debug_packrat << UNINDENT << "Parsed " << packrat_decode[sym]
                   << " at " << pos << " -> " << im << LF;
@@ -733,8 +977,10 @@ packrat_parse (string lan, string sym, tree in) {
 
 bool
 packrat_correct (string lan, string sym, tree in) {
+  bench_start ("packrat parse");
   packrat_parser par= make_packrat_parser (lan, in);
   C pos= par->parse (encode_symbol (compound ("symbol", sym)), 0);
+  bench_cumul ("packrat parse");
   return pos == N(par->current_input);
 }
 
@@ -815,12 +1061,14 @@ packrat_highlight_subtree (string lan, string s, tree in) {
   //cout << "Highlight " << lan << ", " << s << " in " << in << "\n";
   int hl_lan= packrat_abbreviation (lan, s);
   if (hl_lan == 0) return;
+  bench_start ("packrat parse");
   packrat_parser par= make_packrat_parser (lan, in);
   C sym = encode_symbol (compound ("symbol", s));
   if (par->parse (sym, 0) == N(par->current_input)) {
     par->current_hl_lan= hl_lan;
     par->highlight (sym, 0);
   }
+  bench_cumul ("packrat parse");
 }
 
 void
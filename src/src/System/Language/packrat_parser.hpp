@@ -23,6 +23,10 @@ public:
   hashmap<C,array<C> >      grammar;
   hashmap<C,tree>           productions;
   hashmap<D,string>         properties;
+  array<array<C> >          code;
+  array<bool>               nullable;
+  array<bool>               wildcard;
+  array<array<C> >          first;
 
   tree                      current_tree;
   string                    current_string;
@@ -35,6 +39,8 @@ public:
 
   array<C>                  current_input;
   hashmap<D,C>              current_cache;
+  hashmap<D,C>              current_extent;
+  C                         current_examined;
   hashmap<D,tree>           current_production;
 
 protected:
@@ -42,17 +48,20 @@ protected:
   void serialize_compound (tree t, path p);
   void serialize (tree t, path p);
   void set_input (tree t);
+  bool update_serialization (tree t);
   void set_cursor (path t_pos);
   path decode_path (tree t, path p, int pos);
   int  encode_path (tree t, path p, path pos);
 
 public:
   packrat_parser_rep (packrat_grammar gr);
+  void update_input (tree t);
 
   int  decode_string_position (C pos);
   C    encode_string_position (int i);
   path decode_tree_position (C pos);
   C    encode_tree_position (path p);
+  bool may_start (C sym, C pos);
   C    parse (C sym, C pos);
 
   void inspect (C sym, C pos, array<C>& syms, array<C>& poss);
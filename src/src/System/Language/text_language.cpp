@@ -31,8 +31,7 @@
 ******************************************************************************/
 
 struct text_language_rep: language_rep {
-  hashmap<string,string> patterns;
-  hashmap<string,string> hyphenations;
+  hyphenator hyph;
 
   text_language_rep (string lan_name, string hyph_name);
   text_property advance (tree t, int& pos);
@@ -41,8 +40,7 @@ struct text_language_rep: language_rep {
 };
 
 text_language_rep::text_language_rep (string lan_name, string hyph_name):
-  language_rep (lan_name), patterns ("?"), hyphenations ("?") {
-    load_hyphen_tables (hyph_name, patterns, hyphenations, true); }
+  language_rep (lan_name), hyph (load_hyphenator (hyph_name, false)) {}
 
 text_property
 text_language_rep::advance (tree t, int& pos) {
@@ -98,7 +96,7 @@ text_language_rep::advance (tree t, int& pos) {
 
 array<int>
 text_language_rep::get_hyphens (string s) {
-  return ::get_hyphens (s, patterns, hyphenations);
+  return ::get_hyphens (s, hyph);
 }
 
 void
@@ -114,8 +112,7 @@ text_language_rep::hyphenate (
 ******************************************************************************/
 
 struct ucs_text_language_rep: language_rep {
-  hashmap<string,string> patterns;
-  hashmap<string,string> hyphenations;
+  hyphenator hyph;
 
   ucs_text_language_rep (string lan_name, string hyph_name);
   text_property advance (tree t, int& pos);
@@ -125,8 +122,7 @@ struct ucs_text_language_rep: language_rep {
 };
 
 ucs_text_language_rep::ucs_text_language_rep (string lan_name, string hyph_name):
-  language_rep (lan_name), patterns ("?"), hyphenations ("?")
-  { load_hyphen_tables (hyph_name, patterns, hyphenations, false); }
+  language_rep (lan_name), hyph (load_hyphenator (hyph_name, true)) {}
 
 text_property
 ucs_text_language_rep::advance (tree t, int& pos) {
@@ -185,7 +181,7 @@ ucs_text_language_rep::advance (tree t, int& pos) {
 
 array<int>
 ucs_text_language_rep::get_hyphens (string s) {
-  return ::get_hyphens (s, patterns, hyphenations, true);
+  return ::get_hyphens (s, hyph);
 }
 
 void
@@ -27,6 +27,8 @@
 //#undef PATTERN
 #else
 #include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
 #include <signal.h>
 #include <sys/wait.h>
 #endif
@@ -44,6 +46,8 @@ extern char **environ;
 #define IN 0
 #define OUT 1
 #define TERMCHAR '\1'
+#define PIPE_CHUNK 65536
+#define PIPE_FEED  (16 * PIPE_CHUNK)
 
 /******************************************************************************
 * The pipe_link class
@@ -176,6 +180,10 @@ pipe_link_rep::start () {
     err= pp_err [IN ];
     close (pp_err [OUT]);
 
+    // the output of the child is read until no more data are available
+    fcntl (out, F_SETFL, fcntl (out, F_GETFL) | O_NONBLOCK);
+    fcntl (err, F_SETFL, fcntl (err, F_GETFL) | O_NONBLOCK);
+
     alive= true;
     snout = socket_notifier (out, &pipe_callback, this, NULL);
     snerr = socket_notifier (err, &pipe_callback, this, NULL);
@@ -237,28 +245,39 @@ void
 pipe_link_rep::feed (int channel) {
 #ifndef __MINGW32__
   if ((!alive) || ((channel != LINK_OUT) && (channel != LINK_ERR))) return;
-  int r;
-  char tempout[1024];
-  if (channel == LINK_OUT) r = ::read (out, tempout, 1024);
-  else r = ::read (err, tempout, 1024);
-  if (r == -1) {
-    io_error << "Read failed for '" << cmd << "'\n";
-    wait (NULL);
-  }
-  else if (r == 0) {
-    if (-1 != killpg(pid,SIGTERM)) {
-      sleep(2);
-      killpg(pid,SIGKILL);
+  // read large chunks until the pipe is empty
+  // or until PIPE_FEED bytes have been read
+  static char tempout[PIPE_CHUNK];
+  int     fd = (channel == LINK_OUT? out: err);
+  string& buf= (channel == LINK_OUT? outbuf: errbuf);
+  int total= 0;
+  while (total < PIPE_FEED) {
+    int r= ::read (fd, tempout, PIPE_CHUNK);
+    if (r == -1) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) break;
+      io_error << "Read failed for '" << cmd << "'\n";
+      wait (NULL);
+      break;
     }
+    else if (r == 0) {
+      if (-1 != killpg(pid,SIGTERM)) {
+        sleep(2);
+        killpg(pid,SIGKILL);
+      }
 
-    alive= false;
-    remove_notifier (snout);      
-    remove_notifier (snerr);      
-  }
-  else {
-    if (DEBUG_IO) debug_io << debug_io_string (string (tempout, r));
-    if (channel == LINK_OUT) outbuf << string (tempout, r);
-    else errbuf << string (tempout, r);
+      alive= false;
+      remove_notifier (snout);      
+      remove_notifier (snerr);      
+      break;
+    }
+    else {
+      if (DEBUG_IO) debug_io << debug_io_string (string (tempout, r));
+      int n= N(buf);
+      buf->resize (n + r);
+      memcpy (&(buf[n]), tempout, r);
+      total += r;
+      if (r < PIPE_CHUNK) break;
+    }
   }
 #endif
 }
@@ -339,31 +358,29 @@ void pipe_callback (void *obj, void *info) {
 #ifndef __MINGW32__
   (void) info;
   pipe_link_rep* con= (pipe_link_rep*) obj;  
-  bool busy= true;
+  // the pipes are only fed once, so that other links and the editor
+  // get their turn before the remaining output of a busy plugin is read
   bool news= false;
-  while (busy) {
-    fd_set rfds;
-    FD_ZERO (&rfds);
-    int max_fd= max (con->err, con->out) + 1;
-    FD_SET (con->out, &rfds);
-    FD_SET (con->err, &rfds);
-  
-    struct timeval tv;
-    tv.tv_sec  = 0;
-    tv.tv_usec = 0;
-    select (max_fd, &rfds, NULL, NULL, &tv);
-
-    busy= false;
-    if (con->alive && FD_ISSET (con->out, &rfds)) {
-      //cout << "pipe_callback OUT" << LF;
-      con->feed (LINK_OUT);
-      busy= news= true;
-    }
-    if (con->alive && FD_ISSET (con->err, &rfds)) {
-      //cout << "pipe_callback ERR" << LF;
-      con->feed (LINK_ERR);
-      busy= news= true;
-    }
+  fd_set rfds;
+  FD_ZERO (&rfds);
+  int max_fd= max (con->err, con->out) + 1;
+  FD_SET (con->out, &rfds);
+  FD_SET (con->err, &rfds);
+
+  struct timeval tv;
+  tv.tv_sec  = 0;
+  tv.tv_usec = 0;
+  select (max_fd, &rfds, NULL, NULL, &tv);
+
+  if (con->alive && FD_ISSET (con->out, &rfds)) {
+    //cout << "pipe_callback OUT" << LF;
+    con->feed (LINK_OUT);
+    news= true;
+  }
+  if (con->alive && FD_ISSET (con->err, &rfds)) {
+    //cout << "pipe_callback ERR" << LF;
+    con->feed (LINK_ERR);
+    news= true;
   }
   /* FIXME: find out the appropriate place to call the callback
      Currently, the callback is called in tm_server_rep::interpose_handler */
@@ -29,6 +29,9 @@
 #include "socket_notifier.hpp"
 #include "list.hpp"
 #include "iterator.hpp"
+#include "timer.hpp"
+
+#define SELECT_BUDGET 20 // maximal time in ms for handling notifications
 
 static hashset<socket_notifier> notifiers;
 
@@ -58,7 +61,11 @@ remove_notifier (socket_notifier sn)  {
 void 
 perform_select () {
 #ifndef __MINGW32__
-  //FIXME: this can be optimizied
+  // Each round notifies every ready descriptor once, so that busy links
+  // do not starve the others.  After SELECT_BUDGET milliseconds, the
+  // remaining data are left for the next call, so that the editor
+  // remains responsive.
+  time_t start= texmacs_time ();
   while (true) {
     fd_set rfds;
     FD_ZERO (&rfds);
@@ -82,6 +89,7 @@ perform_select () {
       socket_notifier sn=  it->next ();
       if (FD_ISSET (sn->fd, &rfds)) sn->notify ();
     }
+    if (texmacs_time () - start >= SELECT_BUDGET) break;
   }  
 #endif  
 }
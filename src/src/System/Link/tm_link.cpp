@@ -17,11 +17,15 @@
 * Sending data by packets
 ******************************************************************************/
 
+// The packets in a buffer s start at position pos.  Received packets
+// are only removed from the buffer once they make up half of it,
+// so that extracting many small packets from a large buffer is linear.
+
 static bool
-message_complete (string s) {
-  int start= 0;
+message_complete (string s, int pos) {
+  int start= pos;
   int i, n= N(s);
-  if (n>0 && s[0] == '!') start= 1;
+  if (n>pos && s[pos] == '!') start= pos+1;
   for (i=start; i<n; i++)
     if (s[i] == '\n') break;
   if (i == n) return false;
@@ -29,16 +33,18 @@ message_complete (string s) {
 }
 
 static string
-message_receive (string& s) {
-  int start= 0;
+message_receive (string& s, int& pos) {
+  int start= pos;
   int i, n= N(s);
-  if (n>0 && s[0] == '!') start= 1;
+  if (n>pos && s[pos] == '!') start= pos+1;
   for (i=start; i<n; i++)
     if (s[i] == '\n') break;
   if (i == n) return "";
   int l= as_int (s (start, i++));
   string r= s (i, i+l);
-  s= s (i+l, n);
+  pos= i+l;
+  if (pos >= n) { s= ""; pos= 0; }
+  else if (pos >= (n>>1)) { s= s (pos, n); pos= 0; }
   return r;
 }
 
@@ -51,25 +57,29 @@ tm_link_rep::write_packet (string s, int channel) {
 bool
 tm_link_rep::complete_packet (int channel) {
   string s= watch (channel);
-  return message_complete (s);
+  int& pos= done[channel];
+  if (pos > N(s)) pos= 0;
+  return message_complete (s, pos);
 }
 
 string
 tm_link_rep::read_packet (int channel, int timeout, bool& success) {
   success= false;
   string& r= watch (channel);
+  int& pos= done[channel];
+  if (pos > N(r)) pos= 0;
   time_t start= texmacs_time ();
-  while (!message_complete (r)) {
+  while (!message_complete (r, pos)) {
     int n= N(r);
     if (timeout > 0) listen (timeout);
     if (N(r) == n && (texmacs_time () - start >= timeout)) return "";
   }
-  if (channel == LINK_OUT && N(r) > 0 && r[0] == '!') {
-    secure_server (message_receive (r));
+  if (channel == LINK_OUT && N(r) > pos && r[pos] == '!') {
+    secure_server (message_receive (r, pos));
     return "";
   }
   else {
-    string back= message_receive (r);
+    string back= message_receive (r, pos);
     if (secret != "") back= secret_decode (back, secret);
     success= true;
     return back;
@@ -40,11 +40,12 @@
 struct tm_link_rep: abstract_struct {
   bool   alive;   // link is alive
   string secret;  // empty string or secret key for encrypted connections
+  int    done[2]; // received part of the buffers of LINK_OUT and LINK_ERR
 
   command feed_cmd; // called when async data available
   
 public:
-  inline tm_link_rep () {}
+  inline tm_link_rep () { done[0]= done[1]= 0; }
   inline virtual ~tm_link_rep () {}
 
   virtual string  start () = 0;
@@ -21,22 +21,35 @@
 static hashmap<tree,tree> cache_data ("?");
 static hashset<string> cache_loaded;
 static hashset<string> cache_changed;
+static hashset<tree> cache_dirty;
 static hashmap<string,bool> cache_valid (false);
+static hashmap<string,list<tree> > cache_index;
+static bool cache_indexed= false;
+
+static bool is_indexed_buffer (string buffer);
+static void cache_index_insert (tree ckey);
 
 void
 cache_set (string buffer, tree key, tree t) {
   tree ckey= tuple (buffer, key);
   if (cache_data[ckey] != t) {
+    if (cache_indexed && is_indexed_buffer (buffer) &&
+        !cache_data->contains (ckey))
+      cache_index_insert (ckey);
     cache_data (ckey)= t;
     cache_changed->insert (buffer);
+    cache_dirty->insert (ckey);
   }
 }
 
 void
 cache_reset (string buffer, tree key) {
   tree ckey= tuple (buffer, key);
-  cache_data->reset (ckey);
-  cache_changed->insert (buffer);
+  if (cache_data->contains (ckey)) {
+    cache_data->reset (ckey);
+    cache_changed->insert (buffer);
+    cache_dirty->insert (ckey);
+  }
 }
 
 bool
@@ -51,6 +64,52 @@ cache_get (string buffer, tree key) {
   return cache_data [ckey];
 }
 
+/******************************************************************************
+* Removing the cached data for files in out of date directories
+******************************************************************************/
+
+static bool
+is_indexed_buffer (string buffer) {
+  return
+    buffer == "stat_cache.scm" ||
+    buffer == "file_cache" ||
+    buffer == "doc_cache";
+}
+
+static void
+cache_index_insert (tree ckey) {
+  string dir= concretize (url_parent (url_system (ckey[1]->label)));
+  cache_index (dir)= list<tree> (ckey, cache_index [dir]);
+}
+
+static void
+cache_invalidate (string name_dir) {
+  // The entries of the stat, file and document caches are indexed by the
+  // directories which contain the files, so that the entries of an out of
+  // date directory can be removed without going through the whole cache.
+  // The index is only built when a first directory turns out to be
+  // out of date, and then kept up to date by 'cache_set'.
+  if (!cache_indexed) {
+    cache_indexed= true;
+    iterator<tree> it= iterate (cache_data);
+    while (it->busy ()) {
+      tree ckey= it->next ();
+      if (is_indexed_buffer (ckey[0]->label)) cache_index_insert (ckey);
+    }
+  }
+  if (cache_index->contains (name_dir)) {
+    for (list<tree> l= cache_index [name_dir]; !is_nil (l); l= l->next)
+      cache_reset (l->item[0]->label, l->item[1]);
+    cache_index->reset (name_dir);
+  }
+  if (cache_data->contains (tuple ("dir_cache.scm", name_dir)))
+    cache_reset ("dir_cache.scm", name_dir);
+}
+
+/******************************************************************************
+* Checking whether directories are up to date
+******************************************************************************/
+
 bool
 is_up_to_date (url dir) {
   string name_dir= concretize (dir);
@@ -67,13 +126,9 @@ is_up_to_date (url dir) {
   //else cout << name_dir << " not up to date " << l << "\n";
   cache_set ("validate_cache.scm", name_dir, as_string (l));
   cache_valid (name_dir)= false;
-  // FIXME: we should explicitly remove all data concerning files in 'dir'
-  // from the various caches.  Indeed, at a next run of TeXmacs, the directory
-  // will be regarded as up to date, but the other caches may still contain
-  // outdated data.  Careful: invalidating the cache lines should not
-  // give rise to a performance penaly (e.g. go through all entries of
-  // 'cache_data', or reloading unchanged files many times).
-  // See also 'declare_out_of_date'.
+  // Remove the data concerning files in 'dir' from the other caches,
+  // since the directory will be regarded as up to date at a next run.
+  cache_invalidate (name_dir);
   return false;
 }
 
@@ -97,7 +152,7 @@ declare_out_of_date (url dir) {
   int l= last_modified (dir, false);
   cache_set ("validate_cache.scm", name_dir, as_string (l));
   cache_valid (name_dir)= false;
-  // FIXME: see 'FIXME' in 'is_up_to_date'.
+  cache_invalidate (name_dir);
 }
 
 /******************************************************************************
@@ -153,69 +208,219 @@ do_cache_doc (string name) {
 * Saving and loading the cache to/from disk
 ******************************************************************************/
 
+// Each buffer of the cache is stored in a base file, followed by a journal
+// with the modifications since the base file was written.  The journal
+// consists of batches "n checksum\n" followed by n characters, one batch
+// for each save, containing a record (tuple key im) for each modified
+// entry and (tuple key) for each removed entry.  An incomplete or damaged
+// batch, as left behind by an interrupted save, is cut off together with
+// everything behind it before the journal is used or extended.
+// Once the journal becomes larger than the base file, both are compacted
+// into a new base file.  In order to survive interruptions, the new base
+// file is first written to "base.new", then the journal is renamed into
+// "base.log.old", then "base.new" is renamed into the base file, and
+// finally "base.log.old" is removed.  At the next start, an existing
+// "base.log.old" therefore means that "base.new" (if it still exists)
+// is complete and that the compaction only has to be finished, whereas
+// a "base.new" on its own is an incomplete new base file.
+
+#define CACHE_JOURNAL_MIN 65536
+
+static hashmap<string,int> cache_base_size (0);
+static hashmap<string,int> cache_journal_size (0);
+static hashset<string> cache_checked;
+
+static url
+cache_file (string buffer) {
+  return texmacs_home_path * url ("system/cache/" * buffer);
+}
+
+static url
+cache_journal (string buffer) {
+  return texmacs_home_path * url ("system/cache/" * buffer * ".log");
+}
+
+static url
+cache_old_journal (string buffer) {
+  return texmacs_home_path * url ("system/cache/" * buffer * ".log.old");
+}
+
+static void
+cache_recover (string buffer) {
+  // finish or roll back a compaction which was interrupted
+  url temp= cache_file (buffer * ".new");
+  if (exists (cache_old_journal (buffer))) {
+    if (exists (temp)) move (temp, cache_file (buffer));
+    remove (cache_old_journal (buffer));
+  }
+  else if (exists (temp)) remove (temp);
+}
+
+static string
+cache_serialize (string buffer) {
+  string cached;
+  iterator<tree> it= iterate (cache_data);
+  if (buffer == "file_cache" || buffer == "doc_cache") {
+    while (it->busy ()) {
+      tree ckey= it->next ();
+      if (ckey[0] == buffer) {
+	cached << ckey[1]->label << "\n";
+	cached << cache_data [ckey]->label << "\n";
+	cached << "%-%-tm-cache-%-%\n";
+      }
+    }
+  }
+  else {
+    cached << "(tuple\n";
+    while (it->busy ()) {
+      tree ckey= it->next ();
+      if (ckey[0] == buffer) {
+	cached << tree_to_scheme (ckey[1]) << " ";
+	cached << tree_to_scheme (cache_data [ckey]) << "\n";
+      }
+    }
+    cached << ")";
+  }
+  return cached;
+}
+
+static void
+cache_insert (string buffer, tree key, tree im) {
+  tree ckey= tuple (buffer, key);
+  cache_data (ckey)= im;
+  if (cache_indexed && is_indexed_buffer (buffer))
+    cache_index_insert (ckey);
+}
+
+static void
+cache_parse (string buffer, string cached) {
+  if (buffer == "file_cache" || buffer == "doc_cache") {
+    int i=0, n= N(cached);
+    while (i<n) {
+      int start= i;
+      while (i<n && cached[i] != '\n') i++;
+      string key= cached (start, i);
+      i++; start= i;
+      while (i<n && (cached[i] != '\n' ||
+		     !test (cached, i+1, "%-%-tm-cache-%-%"))) i++;
+      string im= cached (start, i);
+      i++;
+      while (i<n && cached[i] != '\n') i++;
+      i++;
+      //cout << "key= " << key << "\n----------------------\n";
+      //cout << "im= " << im << "\n----------------------\n";
+      cache_insert (buffer, key, im);
+    }
+  }
+  else {
+    tree t= scheme_to_tree (cached);
+    for (int i=0; i<N(t)-1; i+=2)
+      cache_insert (buffer, t[i], t[i+1]);
+  }
+}
+
+static string
+cache_batch (string batch) {
+  return as_string (N(batch)) * " " * as_string (hash (batch)) * "\n" * batch;
+}
+
+static int
+cache_replay (string buffer, string journal, bool apply) {
+  // returns the end of the last complete batch of the journal
+  int i=0, n= N(journal);
+  while (i<n) {
+    int start= i;
+    while (i<n && is_digit (journal[i])) i++;
+    if (i == start || i >= n || journal[i] != ' ') return start;
+    int len= as_int (journal (start, i));
+    int mid= ++i;
+    while (i<n && journal[i] != '\n') i++;
+    if (i >= n || i + 1 + len > n) return start;
+    string check= journal (mid, i++);
+    string batch= journal (i, i + len);
+    if (check != as_string (hash (batch))) return start;
+    i += len;
+    if (!apply) continue;
+    tree t= block_to_scheme_tree (batch);
+    for (int j=0; j<N(t); j++) {
+      tree r= scheme_tree_to_tree (t[j]);
+      if (is_tuple (r) && N(r) == 2) cache_insert (buffer, r[0], r[1]);
+      else if (is_tuple (r) && N(r) == 1)
+	cache_data->reset (tuple (buffer, r[0]));
+    }
+  }
+  return n;
+}
+
+static void
+cache_check (string buffer, bool apply) {
+  // replay the journal if requested and cut off a damaged tail
+  string journal;
+  if (!apply) cache_recover (buffer);
+  if (!load_string (cache_journal (buffer), journal, false)) {
+    int end= cache_replay (buffer, journal, apply);
+    if (end < N(journal))
+      (void) save_string (cache_journal (buffer), journal (0, end));
+    cache_journal_size (buffer)= end;
+  }
+  cache_checked->insert (buffer);
+}
+
+static void
+cache_compact (string buffer) {
+  url base= cache_file (buffer);
+  url temp= cache_file (buffer * ".new");
+  url old = cache_old_journal (buffer);
+  string cached= cache_serialize (buffer);
+  if (save_string (temp, cached)) return;
+  if (exists (cache_journal (buffer))) move (cache_journal (buffer), old);
+  else if (save_string (old, "")) { remove (temp); return; }
+  move (temp, base);
+  remove (old);
+  cache_base_size (buffer)= N(cached);
+  cache_journal_size (buffer)= 0;
+  cache_checked->insert (buffer);
+}
+
 void
 cache_save (string buffer) {
   if (cache_changed->contains (buffer)) {
-    url cache_file= texmacs_home_path * url ("system/cache/" * buffer);
-    string cached;
-    iterator<tree> it= iterate (cache_data);
-    if (buffer == "file_cache" || buffer == "doc_cache") {
-      while (it->busy ()) {
-	tree ckey= it->next ();
-	if (ckey[0] == buffer) {
-	  cached << ckey[1]->label << "\n";
-	  cached << cache_data [ckey]->label << "\n";
-	  cached << "%-%-tm-cache-%-%\n";
-	}
+    string batch;
+    list<tree> done;
+    iterator<tree> it= iterate (cache_dirty);
+    while (it->busy ()) {
+      tree ckey= it->next ();
+      if (ckey[0] == buffer) {
+	if (cache_data->contains (ckey))
+	  batch << tree_to_scheme (tuple (ckey[1], cache_data [ckey])) << "\n";
+	else batch << tree_to_scheme (tuple (ckey[1])) << "\n";
+	done= list<tree> (ckey, done);
       }
     }
-    else {
-      cached << "(tuple\n";
-      while (it->busy ()) {
-	tree ckey= it->next ();
-	if (ckey[0] == buffer) {
-	  cached << tree_to_scheme (ckey[1]) << " ";
-	  cached << tree_to_scheme (cache_data [ckey]) << "\n";
-	}
-      }
-      cached << ")";
-    }
-    (void) save_string (cache_file, cached);
+    for (; !is_nil (done); done= done->next)
+      cache_dirty->remove (done->item);
     cache_changed->remove (buffer);
+    if (!cache_checked->contains (buffer)) cache_check (buffer, false);
+    string record= cache_batch (batch);
+    int size= cache_journal_size [buffer] + N(record);
+    if (size > max (cache_base_size [buffer], CACHE_JOURNAL_MIN) ||
+        append_string (cache_journal (buffer), record))
+      cache_compact (buffer);
+    else cache_journal_size (buffer)= size;
   }
 }
 
 void
 cache_load (string buffer) {
   if (!cache_loaded->contains (buffer)) {
-    url cache_file = texmacs_home_path * url ("system/cache/" * buffer);
-    //cout << "cache_file "<< cache_file << LF;
+    //cout << "cache_file "<< cache_file (buffer) << LF;
     string cached;
-    if (!load_string (cache_file, cached, false)) {
-      if (buffer == "file_cache" || buffer == "doc_cache") {
-	int i=0, n= N(cached);
-	while (i<n) {
-	  int start= i;
-	  while (i<n && cached[i] != '\n') i++;
-	  string key= cached (start, i);
-	  i++; start= i;
-	  while (i<n && (cached[i] != '\n' ||
-			 !test (cached, i+1, "%-%-tm-cache-%-%"))) i++;
-	  string im= cached (start, i);
-	  i++;
-	  while (i<n && cached[i] != '\n') i++;
-	  i++;
-	  //cout << "key= " << key << "\n----------------------\n";
-	  //cout << "im= " << im << "\n----------------------\n";
-	  cache_data (tuple (buffer, key))= im;
-	}
-      }
-      else {
-	tree t= scheme_to_tree (cached);
-	for (int i=0; i<N(t)-1; i+=2)
-	  cache_data (tuple (buffer, t[i]))= t[i+1];
-      }
+    cache_recover (buffer);
+    if (!load_string (cache_file (buffer), cached, false)) {
+      cache_parse (buffer, cached);
+      cache_base_size (buffer)= N(cached);
     }
+    cache_check (buffer, true);
     cache_loaded->insert (buffer);
   }
 }
@@ -228,6 +433,8 @@ cache_memorize () {
   cache_save ("stat_cache.scm");
   cache_save ("font_cache.scm");
   cache_save ("validate_cache.scm");
+  cache_save ("grep_cache.scm");
+  cache_save ("page_cache.scm");
 }
 
 void
@@ -235,6 +442,12 @@ cache_refresh () {
   cache_data   = hashmap<tree,tree> ("?");
   cache_loaded = hashset<string> ();
   cache_changed= hashset<string> ();
+  cache_dirty  = hashset<tree> ();
+  cache_base_size   = hashmap<string,int> (0);
+  cache_journal_size= hashmap<string,int> (0);
+  cache_checked     = hashset<string> ();
+  cache_index  = hashmap<string,list<tree> > ();
+  cache_indexed= false;
   cache_load ("file_cache");
   cache_load ("dir_cache.scm");
   cache_load ("stat_cache.scm");
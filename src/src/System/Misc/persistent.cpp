@@ -18,21 +18,28 @@
 * Global data
 ******************************************************************************/
 
+// The key-value pairs of a persistent directory are stored in a single
+// log file, to which a record is appended for each modification.
+// The log is read entirely when the directory is first accessed,
+// so that the current values are kept in memory.  Once the log becomes
+// much larger than the live data, it is compacted into a new log,
+// which atomically replaces the former one.
+
 #define MAX_BRANCH 26
-#define MAX_INNER 10
-#define MAX_SIZE 4096
+#define LOG_MIN_SIZE 65536
 #define MAX_FILES 26
 
-static hashmap<string,string>       persistent_pre   ("");
-static hashmap<string,url>          persistent_file  (url_none ());
-static hashmap<string,unsigned int> persistent_hash  (0);
-static hashmap<string,bool>         persistent_has   (false);
-static hashmap<string,string>       persistent_cache ("");
+static hashmap<string,string> persistent_pre   ("");
+static hashmap<string,url>    persistent_dir   (url_none ());
+static hashmap<string,int>    persistent_size  (0);
+static hashmap<string,int>    persistent_live  (0);
+static hashmap<string,bool>   persistent_has   (false);
+static hashmap<string,string> persistent_cache ("");
 
 static int number_persistent_file_names= -1;
 
 /******************************************************************************
-* Writing and reading hashmaps to and from disk
+* Writing and reading escaped strings
 ******************************************************************************/
 
 void
@@ -46,20 +53,6 @@ write_escaped (string& r, string s) {
   }
 }
 
-void
-persistent_write_map (url file, hashmap<string,string> map) {
-  string s;
-  iterator<string> it= iterate (map);
-  while (it->busy ()) {
-    string key= it->next ();
-    write_escaped (s, key);
-    s << '\n';
-    write_escaped (s, map[key]);
-    s << '\n';
-  }
-  save_string (file, s, false);
-}
-
 string
 read_escaped (string& s, int& i) {
   string r;
@@ -68,6 +61,7 @@ read_escaped (string& s, int& i) {
     char c= s[i];
     if (c == '\\') {
       i++;
+      if (i >= n) break;
       if (s[i] == 'n') r << '\n';
       else if (s[i] == '\\') r << '\\';
     }
@@ -95,164 +89,178 @@ persistent_read_map (url file) {
 }
 
 /******************************************************************************
-* Cache management subroutines
+* Records of the log
 ******************************************************************************/
 
-string
-local_prefix (url dir) {
-  string name= as_string (dir);
-  if (!persistent_pre->contains (name)) {
-    string prefix= as_string (N (persistent_pre) + 1) * ":";
-    persistent_pre (name)= prefix;
-    if (!is_directory (dir)) mkdir (dir);
-    if (!is_directory (dir * url ("_"))) mkdir (dir * url ("_"));
+// A record consists of a line '+key' followed by a line 'val' for setting
+// a value, or of a line '-key' for removing a value, where key and val
+// are escaped.  Each record ends with a line '=checksum'.  Reading stops
+// at the first incomplete or damaged record, as left behind by a crash.
+
+static string
+persistent_record (string key, string val, bool set) {
+  string r;
+  r << (set? '+': '-');
+  write_escaped (r, key);
+  r << '\n';
+  if (set) {
+    write_escaped (r, val);
+    r << '\n';
   }
-  return persistent_pre [name];
+  string check= as_string (hash (r));
+  r << '=' << check << '\n';
+  return r;
 }
 
-void
-persistent_init_key (url dir, string key) {
-  string v= local_prefix (dir) * key;
-  if (!persistent_file->contains (v)) {
-    persistent_file (v)= dir;
-    persistent_hash (v)= (unsigned int) hash (key);
+static int
+persistent_entry_size (string key, string val) {
+  return N(key) + N(val) + 16;
+}
+
+static void
+persistent_apply (string prefix, string key, string val, bool set) {
+  string v= prefix * key;
+  if (persistent_has [v])
+    persistent_live (prefix) -=
+      persistent_entry_size (key, persistent_cache [v]);
+  if (set) {
+    persistent_live (prefix) += persistent_entry_size (key, val);
+    persistent_has   (v)= true;
+    persistent_cache (v)= val;
+  }
+  else {
+    persistent_has   (v)= false;
+    persistent_cache->reset (v);
   }
 }
 
-void
-persistent_update_key (url dir, string key, url file, unsigned int code) {
-  unsigned int ncode= code / MAX_BRANCH;
-  unsigned int mcode= code % MAX_BRANCH;
-  url nfile= file * url (string ((char) (97 + mcode)));
-  string v= local_prefix (dir) * key;
-  persistent_file (v)= nfile;
-  persistent_hash (v)= ncode;
+static bool
+persistent_replay (string prefix, string s) {
+  int i=0, n= N(s);
+  while (i<n) {
+    int start= i;
+    char op= s[i++];
+    if (op != '+' && op != '-') return false;
+    string key= read_escaped (s, i), val;
+    if (op == '+') val= read_escaped (s, i);
+    if (i >= n || s[i] != '=' || s[i-1] != '\n') return false;
+    int end= i++;
+    while (i<n && s[i] != '\n') i++;
+    if (i >= n) return false;
+    if (s (end+1, i) != as_string (hash (s (start, end)))) return false;
+    i++;
+    persistent_apply (prefix, key, val, op == '+');
+  }
+  return true;
 }
 
 /******************************************************************************
-* Storing in cache
+* Loading and compacting logs
 ******************************************************************************/
 
-int
-total_size (hashmap<string,string> map) {
-  int sum= 0;
-  iterator<string> it= iterate (map);
+static void
+persistent_compact (string prefix) {
+  string s;
+  iterator<string> it= iterate (persistent_cache);
   while (it->busy ()) {
-    string key= it->next ();
-    sum += N(key) + N(map[key]);
+    string v= it->next ();
+    if (starts (v, prefix) && persistent_has [v])
+      s << persistent_record (v (N(prefix), N(v)), persistent_cache [v], true);
   }
-  return sum;
+  url log = persistent_dir [prefix] * url ("log");
+  url temp= persistent_dir [prefix] * url ("log.new");
+  if (save_string (temp, s, false)) return;
+  move (temp, log);
+  persistent_size (prefix)= N(s);
 }
 
-void
-persistent_write (url dir, string key, string val,
-                  url file, unsigned int code)
-{
-  string v= local_prefix (dir) * key;
+static void
+persistent_import (string prefix, url file) {
+  // Read the key-value pairs of the former storage scheme,
+  // in which they were distributed over a tree of small files.
   if (is_directory (file)) {
-    persistent_update_key (dir, key, file, code);
-    persistent_write (dir, key, val,
-                      persistent_file [v], persistent_hash [v]);
+    for (int i=0; i<MAX_BRANCH; i++)
+      persistent_import (prefix, file * url (string ((char) (97 + i))));
   }
-  else {
-    hashmap<string,string> map ("");
-    if (is_regular (file))
-      map= persistent_read_map (file);
-    map (key)= val;
-    if (code == 0 || (N (map) <= MAX_INNER && total_size (map) <= MAX_SIZE))
-      persistent_write_map (file, map);
-    else {
-      remove (file);
-      mkdir (file);
-      iterator<string> it= iterate (map);
-      while (it->busy ()) {
-        string skey= it->next ();
-        string sval= map [skey];
-        string sv  = local_prefix (dir) * skey;
-        unsigned int scode= persistent_hash [sv];
-        persistent_write (dir, skey, sval, file, scode);
-      }
+  else if (is_regular (file)) {
+    hashmap<string,string> map= persistent_read_map (file);
+    iterator<string> it= iterate (map);
+    while (it->busy ()) {
+      string key= it->next ();
+      persistent_apply (prefix, key, map[key], true);
     }
   }
 }
 
-void
-persistent_set (url dir, string key, string val) {
-  string v= local_prefix (dir) * key;
-  persistent_init_key (dir, key);
-  persistent_write (dir, key, val, persistent_file [v], persistent_hash [v]);
-  persistent_has   (v)= true;
-  persistent_cache (v)= val;
-}
-
-/******************************************************************************
-* Removing from cache
-******************************************************************************/
-
-void
-persistent_remove (url dir, string key, url file, unsigned int code) {
-  string v= local_prefix (dir) * key;
-  if (is_directory (file)) {
-    persistent_update_key (dir, key, file, code);
-    persistent_remove (dir, key, persistent_file [v], persistent_hash [v]);
+static void
+persistent_load (url dir, string prefix) {
+  url log= dir * url ("log");
+  persistent_dir (prefix)= dir;
+  if (is_regular (log)) {
+    string s;
+    load_string (log, s, false);
+    persistent_size (prefix)= N(s);
+    if (!persistent_replay (prefix, s)) persistent_compact (prefix);
   }
-  else if (is_regular (file)) {
-    hashmap<string,string> map= persistent_read_map (file);
-    if (map->contains (key)) {
-      map->reset (key);
-      persistent_write_map (file, map);
-    }
+  else {
+    persistent_import (prefix, dir);
+    if (persistent_live [prefix] != 0) persistent_compact (prefix);
   }
 }
 
-void
-persistent_reset (url dir, string key) {
-  string v= local_prefix (dir) * key;
-  persistent_init_key (dir, key);
-  persistent_remove (dir, key, persistent_file [v], persistent_hash [v]);
-  persistent_has (v)= false;
-  persistent_cache->reset (v);
+static void
+persistent_append (string prefix, string record) {
+  int size= persistent_size [prefix] + N(record);
+  if (size > 2 * persistent_live [prefix] + LOG_MIN_SIZE ||
+      append_string (persistent_dir [prefix] * url ("log"), record, false))
+    persistent_compact (prefix);
+  else persistent_size (prefix)= size;
+}
+
+string
+local_prefix (url dir) {
+  string name= as_string (dir);
+  if (!persistent_pre->contains (name)) {
+    string prefix= as_string (N (persistent_pre) + 1) * ":";
+    persistent_pre (name)= prefix;
+    if (!is_directory (dir)) mkdir (dir);
+    if (!is_directory (dir * url ("_"))) mkdir (dir * url ("_"));
+    persistent_load (dir, prefix);
+  }
+  return persistent_pre [name];
 }
 
 /******************************************************************************
-* Retrieving from cache
+* Storing, removing and retrieving
 ******************************************************************************/
 
 void
-persistent_retrieve (url dir, string key, url file, unsigned int code) {
-  string v= local_prefix (dir) * key;
-  if (is_directory (file)) {
-    persistent_update_key (dir, key, file, code);
-    persistent_retrieve (dir, key, persistent_file [v], persistent_hash [v]);
-  }
-  else if (is_regular (file)) {
-    hashmap<string,string> map= persistent_read_map (file);
-    if (map->contains (key)) {
-      persistent_cache (v)= map [key];
-      persistent_has   (v)= true;
-    }
-    else persistent_has (v)= false;
-  }
-  else persistent_has (v)= false;
+persistent_set (url dir, string key, string val) {
+  string prefix= local_prefix (dir);
+  string v= prefix * key;
+  if (persistent_has [v] && persistent_cache [v] == val) return;
+  persistent_apply (prefix, key, val, true);
+  persistent_append (prefix, persistent_record (key, val, true));
+}
+
+void
+persistent_reset (url dir, string key) {
+  string prefix= local_prefix (dir);
+  string v= prefix * key;
+  if (!persistent_has [v]) return;
+  persistent_apply (prefix, key, "", false);
+  persistent_append (prefix, persistent_record (key, "", false));
 }
 
 bool
 persistent_contains (url dir, string key) {
   string v= local_prefix (dir) * key;
-  if (!persistent_has->contains (v)) {
-    persistent_init_key (dir, key);
-    persistent_retrieve (dir, key, persistent_file [v], persistent_hash [v]);
-  }
   return persistent_has [v];
 }
 
 string
 persistent_get (url dir, string key) {
   string v= local_prefix (dir) * key;
-  if (!persistent_has->contains (v)) {
-    persistent_init_key (dir, key);
-    persistent_retrieve (dir, key, persistent_file [v], persistent_hash [v]);
-  }
   return persistent_cache [v];
 }
 
@@ -30,6 +30,7 @@ int script_status = 1;
 
 int
 system (string s, string& result) {
+  resolve_reset (); // the command may create or remove files
 #if defined (QTTEXMACS) && (defined (__MINGW__) || defined (__MINGW32__))
   int r= qt_system (s, result);
 #else
@@ -40,6 +41,7 @@ system (string s, string& result) {
 
 int
 system (string s) {
+  resolve_reset (); // the command may create or remove files
   if (DEBUG_STD) debug_shell << s << "\n";
   if (DEBUG_VERBOSE) {
     string result;
@@ -96,6 +98,7 @@ set_env (string var, string with) {
   // do not delete _varw !!!
   // -> known memory leak, but solution more complex than it is worth
 #endif
+  resolve_reset (); // urls may depend on environment variables
 }
 
 url
@@ -22,6 +22,7 @@
 array<tm_buffer> bufs;
 
 string propose_title (string old_title, url u, tree doc);
+void pages_memorize (string doc);
 
 /******************************************************************************
 * Check for changes in the buffer
@@ -62,6 +63,7 @@ remove_buffer (tm_buffer buf) {
   int nr, n= N(bufs);
   for (nr=0; nr<n; nr++)
     if (bufs[nr] == buf) {
+      pages_memorize (as_string (buf->buf->name));
       for (int i=0; i<N(buf->vws); i++)
         delete_view (abstract_view (buf->vws[i]));
       if (n == 1 && number_of_servers () == 0)
@@ -532,6 +534,7 @@ buffer_save (url name) {
   if (fm == "generic") fm= "verbatim";
   bool r= buffer_export (name, name, fm);
   if (!r) pretend_buffer_saved (name);
+  if (!r) pages_memorize (as_string (name));
   return r;
 }
 
@@ -135,6 +135,7 @@ tm_server_rep::refresh () {
 
 void
 tm_server_rep::interpose_handler () {
+  resolve_reset ();
 #ifdef QTTEXMACS
   // TeXmacs/Qt handles delayed messages and socket notification
   // in its own runloop
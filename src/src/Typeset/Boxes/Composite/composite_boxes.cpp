@@ -59,6 +59,7 @@ composite_box_rep::insert (box b, SI x, SI y) {
   bs << b;
   sx(n)= x;
   sy(n)= y;
+  bvh= array<SI> ();
 }
 
 void
@@ -91,6 +92,7 @@ composite_box_rep::left_justify () {
   SI d= x1;
   x1-=d; x2-=d; x3-=d; x4-=d;
   for (i=0; i<n; i++) sx(i) -= d;
+  bvh= array<SI> ();
 }
 
 /******************************************************************************
@@ -198,10 +200,98 @@ composite_box_rep::finalize () {
   */
 }
 
+/******************************************************************************
+* Finding the nearest child
+*******************************************************************************
+* For boxes with many children, such as large tables and graphics, we
+* lazily build a bounding volume hierarchy over consecutive ranges of
+* children. Each node consists of BVH_NODE entries of the array bvh:
+* the range lo..hi of children, the bounding rectangle of these children
+* and the positions in bvh of the two subnodes (or -1 for leaves).
+* Point queries then only descend into nodes which may contain a nearer
+* child than the best one found so far.
+******************************************************************************/
+
+#define BVH_THRESHOLD 64
+#define BVH_LEAF      8
+#define BVH_NODE      8
+
+void
+composite_box_rep::build_bvh (int lo, int hi) {
+  int i, k= N(bvh);
+  bvh->resize (k + BVH_NODE);
+  SI X1= MAX_SI, Y1= MAX_SI, X2= -MAX_SI, Y2= -MAX_SI;
+  for (i=lo; i<hi; i++) {
+    X1= min (X1, sx1(i));
+    Y1= min (Y1, sy1(i));
+    X2= max (X2, sx2(i));
+    Y2= max (Y2, sy2(i));
+  }
+  bvh[k  ]= lo; bvh[k+1]= hi;
+  bvh[k+2]= X1; bvh[k+3]= Y1;
+  bvh[k+4]= X2; bvh[k+5]= Y2;
+  bvh[k+6]= bvh[k+7]= -1;
+  if (hi - lo > BVH_LEAF) {
+    int mid= (lo + hi) >> 1;
+    bvh[k+6]= N(bvh);
+    build_bvh (lo, mid);
+    bvh[k+7]= N(bvh);
+    build_bvh (mid, hi);
+  }
+}
+
+static inline SI
+bvh_distance (array<SI>& bvh, int k, SI x, SI y) {
+  // lower bound for the distances of the children in the node k
+  SI dx= 0, dy= 0;
+  if (x < bvh[k+2]) dx= bvh[k+2] - x;
+  else if (x > bvh[k+4]) dx= x - bvh[k+4];
+  if (y < bvh[k+3]) dy= bvh[k+3] - y;
+  else if (y > bvh[k+5]) dy= y - bvh[k+5];
+  return dx + dy - 1;
+}
+
+void
+composite_box_rep::find_nearest (int k, SI x, SI y, SI delta, bool force,
+                                 int& d, int& m)
+{
+  // Among children at equal distance, the first one is chosen
+  SI lb= bvh_distance (bvh, k, x, y);
+  if (lb > d || (lb == d && bvh[k] > m)) return;
+  if (bvh[k+6] < 0) {
+    for (int i= bvh[k]; i < bvh[k+1]; i++) {
+      SI di= distance (i, x, y, delta);
+      if (di < d || (di == d && i < m))
+        if (bs[i]->accessible () || force) {
+          d= di;
+          m= i;
+        }
+    }
+  }
+  else {
+    int k1= bvh[k+6], k2= bvh[k+7];
+    if (bvh_distance (bvh, k2, x, y) < bvh_distance (bvh, k1, x, y)) {
+      find_nearest (k2, x, y, delta, force, d, m);
+      find_nearest (k1, x, y, delta, force, d, m);
+    }
+    else {
+      find_nearest (k1, x, y, delta, force, d, m);
+      find_nearest (k2, x, y, delta, force, d, m);
+    }
+  }
+}
+
 int
-composite_box_rep::find_child (SI x, SI y, SI delta, bool force) {
-  if (outside (x, delta, x1, x2) && (is_accessible (ip) || force)) return -1;
+composite_box_rep::find_nearest (SI x, SI y, SI delta, bool force) {
   int i, n= subnr(), d= MAX_SI, m= -1;
+  if (n >= BVH_THRESHOLD) {
+    if (N(bvh) == 0 || bvh[1] != n) {
+      bvh= array<SI> ();
+      build_bvh (0, n);
+    }
+    find_nearest (0, x, y, delta, force, d, m);
+    return m;
+  }
   for (i=0; i<n; i++)
     if (distance (i, x, y, delta)< d)
       if (bs[i]->accessible () || force) {
@@ -211,6 +301,12 @@ composite_box_rep::find_child (SI x, SI y, SI delta, bool force) {
   return m;
 }
 
+int
+composite_box_rep::find_child (SI x, SI y, SI delta, bool force) {
+  if (outside (x, delta, x1, x2) && (is_accessible (ip) || force)) return -1;
+  return find_nearest (x, y, delta, force);
+}
+
 path
 composite_box_rep::find_box_path (SI x, SI y, SI delta, bool force) {
   int m= find_child (x, y, delta, force);
@@ -372,14 +468,7 @@ concrete_composite_box_rep::find_child (SI x, SI y, SI delta, bool force) {
   if (border_flag &&
       outside (x, delta, x1, x2) &&
       (is_accessible (ip) || force)) return -1;
-  int i, n= subnr(), d= MAX_SI, m= -1;
-  for (i=0; i<n; i++)
-    if (distance (i, x, y, delta)< d)
-      if (bs[i]->accessible () || force) {
-	d= distance (i, x, y, delta);
-	m= i;
-      }
-  return m;
+  return find_nearest (x, y, delta, force);
 }
 
 /******************************************************************************
@@ -11,6 +11,8 @@
 
 #include "Boxes/composite.hpp"
 #include "Boxes/construct.hpp"
+#include "display_list.hpp"
+#include "gui.hpp"
 
 /******************************************************************************
 * A page box contains a main box and decorations
@@ -94,11 +96,15 @@ struct page_box_rep: composite_box_rep {
   int  page_nr;
   box  decoration;
   int  old_page;
+  int  flat;          // -1: unknown, 0: no display list, 1: display list
+  display_list dl;    // flattened page for fast repainting
+  display_list pdl;   // flattened page for printing and exporting
 
   page_box_rep (path ip, tree page, int page_nr, SI w, SI h,
 		array<box> bs, array<SI> x, array<SI> y, box dec);
   operator tree ();
   int find_child (SI x, SI y, SI delta, bool force);
+  void redraw (renderer ren, path p, rectangles& l);
   void pre_display (renderer& ren);
   void post_display (renderer& ren);
   void display (renderer ren);
@@ -111,7 +117,7 @@ struct page_box_rep: composite_box_rep {
 page_box_rep::page_box_rep (path ip2, tree page2, int nr2, SI w, SI h,
 			    array<box> bs, array<SI> x, array<SI> y, box dec):
   composite_box_rep (ip2, bs, x, y),
-  page (page2), page_nr (nr2), decoration (dec), old_page (0)
+  page (page2), page_nr (nr2), decoration (dec), old_page (0), flat (-1)
 {
   x1= min (x1, 0);
   x2= max (x2, w);
@@ -147,6 +153,66 @@ page_box_rep::find_child (SI x, SI y, SI delta, bool force) {
   return m;
 }
 
+bool enable_display_lists= false;
+
+void
+page_box_rep::redraw (renderer ren, path p, rectangles& l) {
+  // Pages are flattened into display lists for repainting them on screen
+  // and for printing them again; the path p only determines the painting
+  // order, which is irrelevant here.  The display lists die with the page
+  // box, so that a retypeset page is always recorded anew.  Replaying only
+  // paints the parts of the list inside the clipping region of ren.
+  bool screen= ren->is_screen;
+  if (!enable_display_lists || (!screen && !ren->is_printer ()) ||
+      (screen && gui_interrupted ()) || flat == 0) {
+    box_rep::redraw (ren, p, l);
+    return;
+  }
+  SI delta= ren->pixel;
+  if (!ren->is_visible (x0+ x3- delta, y0+ y3- delta,
+			x0+ x4+ delta, y0+ y4+ delta)) return;
+  if (flat == -1) flat= (anim_length () == 0? 1: 0);
+  if (flat == 0) {
+    box_rep::redraw (ren, p, l);
+    return;
+  }
+
+  display_list& cur= (screen? dl: pdl);
+  if (is_nil (cur) || !is_compatible (cur, ren)) {
+    bench_start ("record display list");
+    cur= display_list ();
+    display_list rec_dl (ren);
+    renderer rec= display_list_recorder (rec_dl, ren);
+    rectangles rs;
+    box_rep::redraw (rec, path (), rs);
+    delete_renderer (rec);
+    bench_cumul ("record display list");
+    if (screen && gui_interrupted ()) {
+      box_rep::redraw (ren, p, l);
+      return;
+    }
+    if (!keep_display_list (rec_dl)) {
+      // too much memory is occupied by display lists
+      flat= 0;
+      box_rep::redraw (ren, p, l);
+      return;
+    }
+    cur= rec_dl;
+    if (DEBUG_BENCH)
+      std_bench << "Display list for page " << page_nr << ": "
+		<< N (cur->ops) << " operations, "
+		<< cur->memory () << " bytes\n";
+  }
+
+  bench_start ("replay display list");
+  pre_display (ren);
+  replay (cur, ren);
+  post_display (ren);
+  bench_cumul ("replay display list");
+  l= rectangle (x0+ x3+ ren->ox, y0+ y3+ ren->oy,
+		x0+ x4+ ren->ox, y0+ y4+ ren->oy);
+}
+
 void
 page_box_rep::pre_display (renderer& ren) {
   old_page= ren->cur_page;
@@ -21,6 +21,7 @@
 struct composite_box_rep: public box_rep {
   array<box> bs;  // the children
   path lip, rip;  // left-most and right-most inverse paths
+  array<SI> bvh;  // bounding volume hierarchy for large numbers of children
 
   composite_box_rep (path ip);
   composite_box_rep (path ip, array<box> bs);
@@ -37,6 +38,11 @@ struct composite_box_rep: public box_rep {
   box     subbox (int i);
   void    display (renderer ren);
 
+  void    build_bvh (int lo, int hi);
+  void    find_nearest (int node, SI x, SI y, SI delta, bool force,
+                        int& d, int& m);
+  int     find_nearest (SI x, SI y, SI delta, bool force);
+
   virtual int             find_child (SI x, SI y, SI delta, bool force);
   virtual path            find_box_path (SI x, SI y, SI delta, bool force);
   virtual path            find_lip ();
@@ -125,6 +125,7 @@ void
 replace_bridge (bridge& br, tree st, path ip) {
   bridge new_br= make_bridge (br->ttt, st, ip);
   new_br->changes= br->changes;
+  new_br->reads= br->reads;
   br= new_br;
 }
 
@@ -293,19 +294,30 @@ bridge_rep::typeset (int desired_status) {
   if ((status==desired_status) && (N(ttt->old_patch)==0)) {
     //cout << "cached" << LF;
     env->monitored_patch_env (changes);
+    env->track_join (reads);
     // cout << "changes       = " << changes << LF;
   }
+  else if ((status==desired_status) &&
+	   env->track_independent (reads, ttt->old_patch)) {
+    // the bridge does not read any of the modified variables
+    // nor any references (which are recorded as reading everything)
+    env->track_skip (ttt->old_patch, changes);
+    env->track_join (reads);
+  }
   else {
     // cout << "Typesetting " << st << ", " << desired_status << LF << INDENT;
     //cout << "recomputing" << LF;
     hashmap<string,tree> prev_back (UNINIT);
+    hashset<string> prev_reads;
     my_clean_links ();
     link_repository old_link_env= env->link_env;
     env->link_env= link_env;
     ttt->local_start (l, sb);
     env->local_start (prev_back);
     if (env->hl_lan != 0) env->lan->highlight (st);
+    env->track_start (prev_reads);
     my_typeset (desired_status);
+    env->track_end (prev_reads, reads);
     env->local_update (ttt->old_patch, changes);
     env->local_end (prev_back);
     ttt->local_end (l, sb);
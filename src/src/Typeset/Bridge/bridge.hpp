@@ -40,6 +40,7 @@ public:
   path                 ip;       // source location of the paragraph
   int                  status;   // status among above values
   hashmap<string,tree> changes;  // changes in the environment
+  hashset<string>      reads;    // environment variables read by st
 
   array<page_item>     l;        // the typesetted lines of st
   stack_border         sb;       // border properties of l
@@ -28,6 +28,9 @@ public:
   hashmap<string,tree> old_patch;
   bool paper;
 
+  hashmap<string,tree> pages_env;  // environment when making the pages
+  hashmap<string,box>  pages;      // pages of the previous pass
+
 public:
   typesetter_rep (edit_env& env, tree et, path ip);
 
@@ -17,7 +17,7 @@
 ******************************************************************************/
 
 typesetter_rep::typesetter_rep (edit_env& env2, tree et, path ip):
-  env (env2), old_patch (UNINIT)
+  env (env2), old_patch (UNINIT), pages_env (UNINIT)
 {
   paper= (env->get_string (PAGE_MEDIUM) == "paper");
   br= make_bridge (this, et, ip);
@@ -164,7 +164,10 @@ typesetter_rep::typeset () {
   }
   br->typeset (PROCESSED+ WANTED_PARAGRAPH);
   pager ppp= tm_new<pager_rep> (br->ip, env, l);
+  if (env->same_env (pages_env)) ppp->old_pages= pages;
+  else env->read_env (pages_env);
   box rb= ppp->make_pages ();
+  pages= ppp->new_pages;
   if (env->complete && paper) determine_page_references (rb);
   tm_delete (ppp);
   // env->complete= false;  // moved to edit_typeset_rep::typeset
@@ -192,7 +195,10 @@ typesetter_rep::typeset (SI& x1b, SI& y1b, SI& x2b, SI& y2b) {
 void
 notify_assign (typesetter ttt, path p, tree u) {
   // cout << "Assign " << p << ", " << u << "\n";
-  if (is_nil (p)) ttt->br= make_bridge (ttt, u, ttt->br->ip);
+  if (is_nil (p)) {
+    ttt->br   = make_bridge (ttt, u, ttt->br->ip);
+    ttt->pages= hashmap<string,box> ();
+  }
   else ttt->br->notify_assign (p, u);
 }
 
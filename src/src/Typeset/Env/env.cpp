@@ -28,7 +28,9 @@ edit_env_rep::edit_env_rep (drd_info& drd2,
 			    hashmap<string,tree>& local_aux2,
 			    hashmap<string,tree>& global_aux2):
   drd (drd2),
-  env (UNINIT), back (UNINIT), src (path (DECORATION)),
+  env (UNINIT), back (UNINIT), memo_level (0), memo_frame (0),
+  read_level (0),
+  src (path (DECORATION)),
   var_type (default_var_type),
   base_file_name (base_file_name2),
   cur_file_name (base_file_name2),
@@ -43,6 +45,7 @@ edit_env_rep::edit_env_rep (drd_info& drd2,
   style_init_env ();
   update ();
   complete= false;
+  side_effects= 0;
   recover_env= tuple ();
 }
 
@@ -171,6 +174,26 @@ edit_env_rep::read_env (hashmap<string,tree>& ret) {
   ret= copy (env);
 }
 
+bool
+edit_env_rep::same_env (hashmap<string,tree> h) {
+  // Values are compared by identity, except for strings, since the values
+  // of unchanged variables are shared between typesetting passes
+  track_read ("");  // the result depends on all variables
+  if (N(env) != N(h)) return false;
+  int i=0, n=h->n;
+  for (; i<n; i++) {
+    list<hashentry<string,tree> > l=h->a[i];
+    for (; !is_nil(l); l=l->next) {
+      tree u= env [l->item.key];
+      tree v= l->item.im;
+      if (strong_equal (u, v)) continue;
+      if (is_atomic (u) && is_atomic (v) && u->label == v->label) continue;
+      return false;
+    }
+  }
+  return true;
+}
+
 void
 edit_env_rep::local_start (hashmap<string,tree>& prev_back) {
   prev_back= back;
@@ -186,6 +209,11 @@ edit_env_rep::local_update (hashmap<string,tree>& old_patch,
   change= invert (back, env);
 }
 
+bool
+edit_env_rep::local_modified () {
+  return N (back) != 0;
+}
+
 void
 edit_env_rep::local_end (hashmap<string,tree>& prev_back) {
   int i=0, n=back->n;
@@ -197,6 +225,63 @@ edit_env_rep::local_end (hashmap<string,tree>& prev_back) {
   back= prev_back;
 }
 
+/******************************************************************************
+* Tracking the variables on which bridges depend
+******************************************************************************/
+
+void
+edit_env_rep::track_start (hashset<string>& prev_reads) {
+  prev_reads= reads;
+  reads= hashset<string> ();
+  read_level++;
+}
+
+void
+edit_env_rep::track_end (hashset<string>& prev_reads, hashset<string>& r) {
+  r= reads;
+  reads= prev_reads;
+  read_level--;
+  track_join (r);
+}
+
+void
+edit_env_rep::track_join (hashset<string> r) {
+  if (read_level == 0) return;
+  iterator<string> it= iterate (r);
+  while (it->busy ()) reads->insert (it->next ());
+}
+
+bool
+edit_env_rep::track_independent (hashset<string> r,
+				 hashmap<string,tree> old_patch)
+{
+  // Only variables without derived state (fonts, colors, modes, ...)
+  // can be ignored; the empty name stands for the entire environment
+  if (r->contains ("")) return false;
+  iterator<string> it= iterate (old_patch);
+  while (it->busy ()) {
+    string s= it->next ();
+    if (r->contains (s)) return false;
+    switch (var_type [s]) {
+    case Env_User:
+    case Env_Paragraph:
+    case Env_Page:
+      break;
+    default:
+      return false;
+    }
+  }
+  return true;
+}
+
+void
+edit_env_rep::track_skip (hashmap<string,tree>& old_patch,
+			  hashmap<string,tree> change)
+{
+  monitored_patch_env (change);
+  old_patch->post_patch (change, env);
+}
+
 tm_ostream&
 operator << (tm_ostream& out, edit_env env) {
   return out << env->env;
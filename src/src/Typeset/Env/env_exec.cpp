@@ -165,6 +165,131 @@ texmacs_exec (edit_env env, tree cmd) {
   return env->exec (cmd);
 }
 
+/******************************************************************************
+* Memoized macro expansion
+******************************************************************************/
+
+#define MAX_MEMO_BYTES 4000000
+#define MAX_MEMO_READS 64
+
+// Macro applications are identified by stamps (see stamp_observer.cpp),
+// which disappear as soon as the application is modified.  This avoids
+// hashing, comparing and copying the application on each expansion.
+
+static hashmap<int,tree> memo_expansion (UNINIT);
+static int memo_bytes= 0;
+
+static int
+memo_size (tree t) {
+  // rough estimate of the memory occupied by t
+  if (is_atomic (t)) return 16 + N(t->label);
+  int i, n= N(t), r= 16 + 8 * n;
+  for (i=0; i<n; i++) r += memo_size (t[i]);
+  return r;
+}
+
+static bool
+memo_pure (tree_label l) {
+  // Primitives whose evaluation depends on more than the values of
+  // environment variables, the macro arguments and their children
+  switch (l) {
+  case ASSIGN: case DRD_PROPS: case MAP_ARGS: case EXTERN: case INCLUDE:
+  case USE_PACKAGE: case USE_MODULE: case REWRITE_INACTIVE:
+  case PLUS: case MINUS: case TIMES: case OVER: case DIV: case MOD:
+  case MINIMUM: case MAXIMUM: case MATH_SQRT: case EXP: case LOG: case POW:
+  case COS: case SIN: case TAN: case _DATE: case TRANSLATE: case CHANGE_CASE:
+  case FIND_FILE: case EQUAL: case UNEQUAL: case LESS: case LESSEQ:
+  case GREATER: case GREATEREQ:
+  case CM_LENGTH: case MM_LENGTH: case IN_LENGTH: case PT_LENGTH:
+  case BP_LENGTH: case DD_LENGTH: case PC_LENGTH: case CC_LENGTH:
+  case FS_LENGTH: case FBS_LENGTH: case EM_LENGTH: case LN_LENGTH:
+  case SEP_LENGTH: case YFRAC_LENGTH: case EX_LENGTH: case FN_LENGTH:
+  case FNS_LENGTH: case BLS_LENGTH: case FNBOT_LENGTH: case FNTOP_LENGTH:
+  case SPC_LENGTH: case XSPC_LENGTH: case PAR_LENGTH: case PAG_LENGTH:
+  case GW_LENGTH: case GH_LENGTH: case GU_LENGTH: case TMPT_LENGTH:
+  case PX_LENGTH: case MSEC_LENGTH: case SEC_LENGTH: case MIN_LENGTH:
+  case HR_LENGTH:
+  case HARD_ID: case SCRIPT: case FIND_ACCESSIBLE:
+  case SET_BINDING: case GET_BINDING: case PATTERN: case _POINT:
+  case EFF_MOVE: case EFF_BUBBLE: case EFF_GAUSSIAN: case EFF_OVAL:
+  case EFF_RECTANGULAR: case EFF_MOTION:
+  case BOX_INFO: case FRAME_DIRECT: case FRAME_INVERSE:
+    return false;
+  default:
+    return true;
+  }
+}
+
+void
+edit_env_rep::memo_read (string s) {
+  memo_vars << s;
+  if (env->contains (s)) memo_vals << env [s];
+  else memo_vals << tree (UNINIT, "undefined");
+}
+
+bool
+edit_env_rep::memo_valid (tree e) {
+  // e= (tuple result var_1 val_1 ... var_n val_n)
+  int i, n= N(e);
+  for (i=1; i<n; i+=2) {
+    string s= e[i]->label;
+    tree   v= env->contains (s)? env [s]: tree (UNINIT, "undefined");
+    if (!strong_equal (v, e[i+1]) && v != e[i+1]) return false;
+  }
+  return true;
+}
+
+tree
+edit_env_rep::exec_compound (tree t) {
+  // The expansion of a macro application is reused whenever the
+  // environment variables which were read during the expansion
+  // still have the same values.  Expansions which access macro
+  // arguments outside t or impure primitives are not memorized.
+  int stamp;
+  if (obtain_stamp (t, stamp) && memo_expansion->contains (stamp)) {
+    tree e= memo_expansion [stamp];
+    if (memo_valid (e)) {
+      int i, n= N(e);
+      for (i=1; i<n; i+=2) {
+	track_read (e[i]->label);
+	if (memo_level > 0) {
+	  memo_vars << e[i]->label;
+	  memo_vals << e[i+1];
+	}
+      }
+      return copy (e[0]);
+    }
+  }
+
+  int base= N (macro_arg), start= N (memo_vars), old_frame= memo_frame;
+  memo_level++;
+  memo_frame= base + 1;
+  tree r= exec_macro (t);
+  memo_level--;
+  int n= N (memo_vars) - start;
+  if (memo_frame > base && n <= MAX_MEMO_READS) {
+    tree e (TUPLE, 2*n + 1);
+    e[0]= copy (r);
+    for (int i=0; i<n; i++) {
+      e[2*i+1]= memo_vars[start+i];
+      e[2*i+2]= memo_vals[start+i];
+    }
+    int size= memo_size (e[0]) + 32 * n;
+    if (memo_bytes + size > MAX_MEMO_BYTES) {
+      memo_expansion= hashmap<int,tree> (UNINIT);
+      memo_bytes= 0;
+    }
+    memo_expansion (attach_stamp (t))= e;
+    memo_bytes += size;
+  }
+  if (memo_level == 0) {
+    memo_vars= array<string> ();
+    memo_vals= array<tree> ();
+  }
+  else memo_frame= min (old_frame, memo_frame);
+  return r;
+}
+
 /******************************************************************************
 * Evaluation of trees
 ******************************************************************************/
@@ -173,6 +298,7 @@ tree
 edit_env_rep::exec (tree t) {
   // cout << "Execute: " << t << "\n";
   if (is_atomic (t)) return t;
+  if (memo_level > 0 && !memo_pure (L(t))) memo_frame= -1;
   switch (L(t)) {
   case DATOMS:
     return exec_formatting (t, ATOM_DECORATIONS);
@@ -553,7 +679,7 @@ edit_env_rep::exec_with (tree t) {
 }
 
 tree
-edit_env_rep::exec_compound (tree t) {
+edit_env_rep::exec_macro (tree t) {
   int d; tree f;
   if (L(t) == COMPOUND) {
     if (N(t)<1) return tree (ERROR, "bad compound");
@@ -757,6 +883,7 @@ edit_env_rep::exec_arg (tree t) {
     return tree (ERROR, "bad arg");
   if (is_nil (macro_arg) || (!macro_arg->item->contains (r->label)))
     return tree (ERROR, "arg " * r->label);
+  if (memo_level > 0) memo_frame= min (memo_frame, N (macro_arg));
   r= macro_arg->item [r->label];
   list<hashmap<string,tree> > old_var= macro_arg;
   list<hashmap<string,path> > old_src= macro_src;
@@ -790,6 +917,7 @@ edit_env_rep::exec_quote_arg (tree t) {
     return tree (ERROR, "bad quote-arg");
   if (is_nil (macro_arg) || (!macro_arg->item->contains (r->label)))
     return tree (ERROR, "quoted argument " * r->label);
+  if (memo_level > 0) memo_frame= min (memo_frame, N (macro_arg));
   r= macro_arg->item [r->label];
   if (N(t) > 1) {
     int i, n= N(t);
@@ -829,6 +957,7 @@ tree
 edit_env_rep::exec_eval_args (tree t) {
   if (N(t)<1) return tree (ERROR, "bad eval-args");
   if(is_nil(macro_arg)) return tree(ERROR, "nil argument");
+  if (memo_level > 0) memo_frame= min (memo_frame, N (macro_arg));
   tree v= macro_arg->item [as_string (t[0])];
   if (is_atomic (v)) return tree (ERROR, "eval arguments " * t[0]->label);
   list<hashmap<string,tree> > old_var= macro_arg;
@@ -1591,6 +1720,8 @@ edit_env_rep::exec_find_accessible (tree t) {
 tree
 edit_env_rep::exec_set_binding (tree t) {
   tree keys, value;
+  side_effects++;
+  track_read ("");  // references are not environment variables
   if (N(t) == 1) {
     keys= read ("the-tags");
     if (!is_tuple (keys)) {
@@ -1655,6 +1786,8 @@ edit_env_rep::exec_set_binding (tree t) {
 tree
 edit_env_rep::exec_get_binding (tree t) {
   if (N(t) != 1 && N(t) != 2) return tree (ERROR, "bad get binding");
+  side_effects++;
+  track_read ("");  // references are not environment variables
   string key= exec_string (t[0]);
   tree value= local_ref->contains (key)? local_ref [key]: global_ref [key];
   int type= (N(t) == 1? 0: as_int (exec_string (t[1])));
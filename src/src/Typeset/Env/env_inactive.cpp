@@ -321,6 +321,7 @@ edit_env_rep::rewrite_inactive_var_active (
   tree t, tree var, bool block, bool flush)
 {
   (void) block;
+  track_read (MODE);
   tree r= tree (WITH, MODE, copy (env [MODE]), subvar (var, 0));
   if (flush &&
       (src_compact != COMPACT_ALL) &&
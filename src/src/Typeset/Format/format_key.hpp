@@ -0,0 +1,50 @@
+
+/******************************************************************************
+* MODULE     : format_key.hpp
+* DESCRIPTION: Binary keys for memorizing line and page breaking results
+* COPYRIGHT  : (C) 2026  agent
+*******************************************************************************
+* This software falls under the GNU general public license version 3 or later.
+* It comes WITHOUT ANY WARRANTY WHATSOEVER. For details, see the file LICENSE
+* in the root directory or <http://www.gnu.org/licenses/gpl-3.0.html>.
+******************************************************************************/
+
+#ifndef FORMAT_KEY_H
+#define FORMAT_KEY_H
+#include "space.hpp"
+#include "tree.hpp"
+
+inline void
+key_add (string& key, int x) {
+  key << ((char) (x & 255)) << ((char) ((x >> 8) & 255))
+      << ((char) ((x >> 16) & 255)) << ((char) ((x >> 24) & 255));
+}
+
+inline void
+key_add (string& key, double x) {
+  key << string ((char*) ((void*) &x), sizeof (double));
+}
+
+inline void
+key_add (string& key, space spc) {
+  key_add (key, spc->min);
+  key_add (key, spc->def);
+  key_add (key, spc->max);
+}
+
+inline void
+key_add (string& key, tree t) {
+  if (is_atomic (t)) {
+    key_add (key, -1);
+    key_add (key, N (t->label));
+    key << t->label;
+  }
+  else {
+    int i, n= N(t);
+    key_add (key, (int) L(t));
+    key_add (key, n);
+    for (i=0; i<n; i++) key_add (key, t[i]);
+  }
+}
+
+#endif // defined FORMAT_KEY_H
@@ -20,8 +20,8 @@
 array<line_item> typeset_concat (edit_env env, tree t, path ip);
 void hyphenate (line_item item, int pos, line_item& item1, line_item& item2);
 array<path>
-line_breaks (array<line_item> a, int start, int end,
-	     SI line_width, SI first_spc, SI last_spc, bool ragged);
+cached_line_breaks (array<line_item> a, int start, int end,
+                    SI line_width, SI first_spc, SI last_spc, bool ragged);
 
 /******************************************************************************
 * Constructor
@@ -524,8 +524,8 @@ lazy_paragraph_rep::line_units (
 
   int i;
   bool ragged= (hyphen == "normal");
-  array<path> hyphs= line_breaks (a, start, end, the_right-the_left,
-				  the_first, the_last, ragged);
+  array<path> hyphs= cached_line_breaks (a, start, end, the_right-the_left,
+					 the_first, the_last, ragged);
   for (i=0; i<N(hyphs)-1; i++) {
     if (i>0) line_start ();
     line_unit (hyphs[i], hyphs[i+1], i==N(hyphs)-2, mode,
@@ -11,7 +11,10 @@
 
 #include "Boxes/construct.hpp"
 #include "Format/line_item.hpp"
+#include "Format/format_key.hpp"
+#include "timer.hpp"
 #define PEN DI
+#define MAX_CACHED_BREAKS 2048
 
 /******************************************************************************
 * Information about the best line breaks
@@ -57,11 +60,17 @@ struct line_breaker_rep {
   SI  first_spc;
   SI  last_spc;
   int pass;
-  hashmap<path,lb_info> best;
+  array<lb_info> best_item;     // best breaks before the items start..end
+  hashmap<path,lb_info> best;   // best breaks inside hyphenated items
+  array<array<SI> > hyph_width; // widths of the hyphenated items start..end
 
   line_breaker_rep (array<line_item> a, int start, int end,
 		    SI line_width, SI first_spc, SI last_spc);
 
+  lb_info get_best (path pos);
+  lb_info set_best (path pos);
+  SI hyphen_width (line_item item, int i, int j, bool cache);
+
   void empty_line_fix (line_item& first, path& pos, int& cur_nr);
   path next_ragged_break (path pos);
   array<path> compute_ragged_breaks ();
@@ -79,7 +88,30 @@ line_breaker_rep::line_breaker_rep (
   SI line_width2, SI first_spc2, SI last_spc2):
     a (a2), start (start2), end (end2),
     line_width (line_width2), first_spc (first_spc2), last_spc (last_spc2),
-    best (lb_info ()) {}
+    best_item (max (end2 - start2 + 1, 0)), best (lb_info ()),
+    hyph_width (max (end2 - start2, 0)) {}
+
+/******************************************************************************
+* Access to the best line breaks
+*******************************************************************************
+* Breaks between items are stored densely in best_item;
+* the hashmap best is only used for breaks inside hyphenated items.
+******************************************************************************/
+
+lb_info
+line_breaker_rep::get_best (path pos) {
+  if (is_atom (pos) && pos->item >= start && pos->item <= end)
+    return best_item [pos->item - start];
+  return best [pos];
+}
+
+lb_info
+line_breaker_rep::set_best (path pos) {
+  if (is_atom (pos) && pos->item >= start && pos->item <= end)
+    return best_item [pos->item - start];
+  if (!best->contains (pos)) best (pos)= lb_info ();
+  return best [pos];
+}
 
 /******************************************************************************
 * Some subroutines
@@ -132,6 +164,29 @@ hyphenate (line_item item, int pos, line_item& item1, line_item& item2) {
   // cout << s << " ---> " << s1 << " " << s2 << "\n";
 }
 
+SI
+line_breaker_rep::hyphen_width (line_item item, int i, int j, bool cache) {
+  // Width of the first part of item when hyphenating after position j;
+  // the widths are cached for the unhyphenated items of the paragraph
+  if (cache && i >= start && i < end) {
+    array<SI>& w= hyph_width [i - start];
+    if (j >= N(w)) {
+      int k, n= N(w);
+      w->resize (j+1);
+      for (k=n; k<=j; k++) w[k]= (SI) MIN_SI;
+    }
+    if (w[j] == (SI) MIN_SI) {
+      line_item item1, item2;
+      hyphenate (item, j, item1, item2);
+      w[j]= item1->b->w();
+    }
+    return w[j];
+  }
+  line_item item1, item2;
+  hyphenate (item, j, item1, item2);
+  return item1->b->w();
+}
+
 /******************************************************************************
 * Naive line breaking for ragged paragraph types
 ******************************************************************************/
@@ -256,8 +311,7 @@ void
 line_breaker_rep::test_better (path new_pos, path old_pos,
 			       int pen, PEN pen_spc)
 {
-  if (!best->contains (new_pos)) best (new_pos)= lb_info ();
-  lb_info cur= best [new_pos];
+  lb_info cur= set_best (new_pos);
   //cout << "Test " << new_pos << " vs " << old_pos
   //     << ", " << pen << " vs " << cur->pen
   //     << ", " << pen_spc << " vs " << cur->pen_spc << "\n";
@@ -276,7 +330,7 @@ bool
 line_breaker_rep::propose_break (path new_pos, path old_pos,
 				 int pen, space spc)
 {
-  lb_info cur= best[old_pos];
+  lb_info cur= get_best (old_pos);
 
   if ((spc->min <= line_width) &&
       ((spc->max >= line_width) || (new_pos->item==end))) {
@@ -313,15 +367,14 @@ line_breaker_rep::break_string (line_item item, path pos, int i, space spc) {
   int j;
   string item_s= item->b->get_leaf_string ();
   array<int> hp= item->lan->get_hyphens (item_s);
+  bool cache= is_atom (pos) || i != pos->item;
 
   if ((item->b->w() > line_width) || (!is_atom (pos))) {
     j= get_position (item->b->get_leaf_font (), item_s, line_width- spc->def);
     for (j= min (j+2, N(hp)-1); j>=0; j--)
       if (hp[j] < HYPH_INVALID) {
-	line_item item1, item2;
-	hyphenate (item, j, item1, item2);
 	path next= (i==pos->item)? pos * j: path (i, j);
-	space spc_hyph= spc+ space (item1->b->w());
+	space spc_hyph= spc+ space (hyphen_width (item, i, j, cache));
 	if (spc_hyph->min <= line_width) {
 	  propose_break (next, pos, hp[j], spc_hyph->min);
 	  break;
@@ -331,10 +384,8 @@ line_breaker_rep::break_string (line_item item, path pos, int i, space spc) {
   else {
     for (j=0; j<N(hp); j++)
       if (hp[j] < HYPH_INVALID) {
-	line_item item1, item2;
-	hyphenate (item, j, item1, item2);
 	path next= (i==pos->item)? pos * j: path (i, j);
-	space spc_hyph= spc+ space (item1->b->w());
+	space spc_hyph= spc+ space (hyphen_width (item, i, j, cache));
 	(void) propose_break (next, pos, hp[j], spc_hyph);
       }
   }
@@ -359,7 +410,7 @@ line_breaker_rep::process (path pos) {
     spc= space (first->b->w());
   }
 
-  if ((pass>1) || (best[pos]->pen < HYPH_INVALID)) {
+  if ((pass>1) || (get_best (pos)->pen < HYPH_INVALID)) {
     // cout << "Process " << pos << ": " << first << "\n";
     for (i=pos->item; i<end; i++) {
       line_item item= a[i];
@@ -402,7 +453,7 @@ line_breaker_rep::process (path pos) {
 void
 line_breaker_rep::get_breaks (array<path>& ap, path p) {
   if (is_nil (p)) return;
-  lb_info cur= best[p];
+  lb_info cur= get_best (p);
   get_breaks (ap, cur->prev);
   ap << p;
 }
@@ -417,7 +468,7 @@ line_breaker_rep::compute_breaks () {
     process (path (i));
 
   pass= 2;
-  if (best [path (end)]->pen == HYPH_INVALID)
+  if (get_best (path (end))->pen == HYPH_INVALID)
     for (i=start; i<end; i++)
       process (path (i));
 
@@ -459,3 +510,68 @@ line_breaks (array<line_item> a, int start, int end,
   tm_delete (H);
   return ap;
 }
+
+/******************************************************************************
+* Caching line breaks
+*******************************************************************************
+* The line breaks only depend on the dimensions, penalties and strings
+* of the line_items, so we may reuse them whenever a paragraph with the
+* same contents and parameters is typeset again, for instance after
+* modifications elsewhere in the document. Since the cache is keyed by
+* contents, it never needs to be invalidated; it is simply flushed when
+* it gets too large. The numbers of invocations of the benchmark tasks
+* "line breaks" and "cached line breaks" give the hit rate.
+******************************************************************************/
+
+static hashmap<string,array<path> > break_cache;
+
+static string
+line_breaks_key (array<line_item> a, int start, int end,
+                 SI line_width, SI first_spc, SI last_spc, bool ragged)
+{
+  string key;
+  key_add (key, start);
+  key_add (key, end);
+  key_add (key, line_width);
+  key_add (key, first_spc);
+  key_add (key, last_spc);
+  key_add (key, ragged? 1: 0);
+  for (int i=start; i<end; i++) {
+    line_item item= a[i];
+    key_add (key, item->type);
+    key_add (key, item->penalty);
+    key_add (key, item->b->w ());
+    key_add (key, item->spc);
+    if (item->type == STRING_ITEM) {
+      string s= item->b->get_leaf_string ();
+      key_add (key, N(s));
+      key << s << item->b->get_leaf_font ()->res_name << '\0'
+          << item->lan->lan_name << '\0';
+    }
+    else if (item->type == CONTROL_ITEM)
+      key_add (key, item->t == LINE_BREAK? 1: 0);
+  }
+  return key;
+}
+
+array<path>
+cached_line_breaks (array<line_item> a, int start, int end,
+                    SI line_width, SI first_spc, SI last_spc, bool ragged)
+{
+  string key= line_breaks_key (a, start, end,
+                               line_width, first_spc, last_spc, ragged);
+  if (break_cache->contains (key)) {
+    bench_start ("cached line breaks");
+    array<path> ap= break_cache [key];
+    bench_cumul ("cached line breaks");
+    return ap;
+  }
+  bench_start ("line breaks");
+  array<path> ap= line_breaks (a, start, end,
+                               line_width, first_spc, last_spc, ragged);
+  bench_cumul ("line breaks");
+  if (N(break_cache) >= MAX_CACHED_BREAKS)
+    break_cache= hashmap<string,array<path> > ();
+  break_cache (key)= ap;
+  return ap;
+}
@@ -11,6 +11,7 @@
 
 #include "Format/page_item.hpp"
 #include "Format/stack_border.hpp"
+#include "Format/format_key.hpp"
 #include "pager.hpp"
 box format_stack (path ip, array<box> bx, array<space> ht, SI height,
 		  bool may_stretch);
@@ -19,11 +20,24 @@ array<page_item> sub (array<page_item> l, path p, path q);
 SI stretch_space (space spc, double stretch);
 page_item access (array<page_item> l, path p);
 skeleton break_pages (array<page_item> l, space ph, int qual,
-		      space fn_sep, space fnote_sep, space float_sep, font fn);
+		      space fn_sep, space fnote_sep, space float_sep, font fn,
+		      string doc);
 box page_box (path ip, box b, tree page, int page_nr,
               SI width, SI height, SI left, SI top,
 	      SI bot, box header, box footer, SI head_sep, SI foot_sep);
 
+void
+pager_rep::pages_control (page_item item) {
+  if (is_tuple (item->t, "env_page")) {
+    if (((item->t[1] == PAGE_THIS_HEADER) ||
+	 (item->t[1] == PAGE_THIS_FOOTER)) &&
+	(item->t[2] == "")) style (item->t[1]->label)= " ";
+    else if (item->t[1] == PAGE_NR)
+      page_offset= as_int (item->t[2]->label)- N(pages)- 1;
+    else style (item->t[1]->label)= copy (item->t[2]);
+  }
+}
+
 box
 pager_rep::pages_format (array<page_item> l, SI ht, SI tcor, SI bcor) {
   // cout << "Formatting insertion of height " << ht << LF;
@@ -33,16 +47,7 @@ pager_rep::pages_format (array<page_item> l, SI ht, SI tcor, SI bcor) {
   array<space> spc;
   for (i=0; i<n; i++) {
     page_item item= l[i];
-    if (item->type == PAGE_CONTROL_ITEM) {
-      if (is_tuple (item->t, "env_page")) {
-	if (((item->t[1] == PAGE_THIS_HEADER) ||
-	     (item->t[1] == PAGE_THIS_FOOTER)) &&
-	    (item->t[2] == "")) style (item->t[1]->label)= " ";
-	else if (item->t[1] == PAGE_NR)
-	  page_offset= as_int (item->t[2]->label)- N(pages)- 1;
-	else style (item->t[1]->label)= copy (item->t[2]);
-      }
-    }
+    if (item->type == PAGE_CONTROL_ITEM) pages_control (item);
     else {
       bs  << item->b;
       spc << item->spc;
@@ -152,27 +157,122 @@ pager_rep::pages_format (pagelet pg) {
   }
 }
 
+/******************************************************************************
+* Reusing the pages of the previous pass
+******************************************************************************/
+
+static void
+key_add (string& key, box b) {
+  // The boxes of unchanged paragraphs are shared between passes and
+  // remain alive as long as the pages which contain them are cached
+  pointer ptr= (pointer) b.operator -> ();
+  key << string ((char*) ((void*) &ptr), sizeof (pointer));
+}
+
+bool
+pager_rep::pages_key (string& key, array<page_item> l) {
+  int i, n= N(l);
+  key_add (key, n);
+  for (i=0; i<n; i++) {
+    page_item item= l[i];
+    key_add (key, item->type);
+    if (item->type == PAGE_CONTROL_ITEM) pages_control (item);
+    else {
+      key_add (key, item->b);
+      key_add (key, item->spc);
+    }
+  }
+  return true;
+}
+
+bool
+pager_rep::pages_key (string& key, insertion ins) {
+  key_add (key, ins->type);
+  key_add (key, ins->ht);
+  key_add (key, ins->stretch);
+  key_add (key, ins->top_cor);
+  key_add (key, ins->bot_cor);
+  if (is_tuple (ins->type, "multi-column")) {
+    int col, nr_cols= N (ins->sk);
+    key_add (key, nr_cols);
+    for (col=0; col<nr_cols; col++)
+      if (!pages_key (key, ins->sk[col])) return false;
+    return true;
+  }
+  else return pages_key (key, sub (l, ins->begin, ins->end));
+}
+
+bool
+pager_rep::pages_key (string& key, pagelet pg) {
+  // Empty pagelets depend on the previous page
+  int i, n= N (pg->ins);
+  if (n == 0) return false;
+  key_add (key, n);
+  for (i=0; i<n; i++)
+    if (!pages_key (key, pg->ins[i])) return false;
+  return true;
+}
+
+/******************************************************************************
+* Making the pages
+******************************************************************************/
+
 box
 pager_rep::pages_make_page (pagelet pg) {
-  box sb= pages_format (pg);
-  box lb= move_box (ip, sb, 0, 0);
+  string key;
+  bool memo= pages_key (key, pg);
+  int effects= env->side_effects;
   int nr= N(pages) + 1 + page_offset;
   SI  left= (nr&1)==0? even: odd;
   env->write (PAGE_NR, as_string (nr));
   env->write (PAGE_THE_PAGE, style[PAGE_THE_PAGE]);
   tree page_t= env->exec (compound (PAGE_THE_PAGE));
+  if (memo) {
+    bool odd_page= (N(pages)&1) == 0;
+    key_add (key, nr);
+    key_add (key, page_t);
+    key_add (key, style[odd_page? PAGE_ODD_HEADER: PAGE_EVEN_HEADER]);
+    key_add (key, style[odd_page? PAGE_ODD_FOOTER: PAGE_EVEN_FOOTER]);
+    key_add (key, style[PAGE_THIS_HEADER]);
+    key_add (key, style[PAGE_THIS_FOOTER]);
+    if (old_pages->contains (key)) {
+      if (show_hf) {
+	style (PAGE_THIS_HEADER)= "";
+	style (PAGE_THIS_FOOTER)= "";
+      }
+      box pb= old_pages[key];
+      new_pages (key)= pb;
+      return pb;
+    }
+  }
+
+  box sb= pages_format (pg);
+  box lb= move_box (ip, sb, 0, 0);
   box header= make_header (N (pg->ins) == 0);
   box footer= make_footer (N (pg->ins) == 0);
-  return page_box (ip, lb, page_t, nr,
-		   width, height, left, top, top+ text_height,
-		   header, footer, head_sep, foot_sep);
+  box pb= page_box (ip, lb, page_t, nr,
+		    width, height, left, top, top+ text_height,
+		    header, footer, head_sep, foot_sep);
+  // Pages whose number, header or footer depend on references
+  // or other auxiliary data cannot be reused during later passes
+  if (memo && env->side_effects == effects) new_pages (key)= pb;
+  return pb;
+}
+
+string
+pager_rep::pages_document () {
+  // page breaks are only remembered for documents on disk
+  url name= env->base_file_name;
+  if (!is_rooted (name, "default") && !is_rooted (name, "file")) return "";
+  return as_string (name);
 }
 
 void
 pager_rep::pages_make () {
   space ht (text_height- may_shrink, text_height, text_height+ may_extend);
   skeleton sk=
-    break_pages (l, ht, quality, fn_sep, fnote_sep, float_sep, env->fn);
+    break_pages (l, ht, quality, fn_sep, fnote_sep, float_sep, env->fn,
+		 pages_document ());
   int i, n= N(sk);
   for (i=0; i<n; i++)
     pages << pages_make_page (sk[i]);
@@ -182,7 +282,8 @@ void
 pager_rep::papyrus_make () {
   space ht (MAX_SI >> 1);
   skeleton sk=
-    break_pages (l, ht, quality, fn_sep, fnote_sep, float_sep, env->fn);
+    break_pages (l, ht, quality, fn_sep, fnote_sep, float_sep, env->fn,
+		 pages_document ());
   if (N(sk) != 1) {
     failed_error << "Number of pages: " << N(sk) << "\n";
     FAILED ("unexpected situation");
@@ -12,6 +12,7 @@
 #include "Line/lazy_vstream.hpp"
 #include "vpenalty.hpp"
 #include "skeleton.hpp"
+#include "data_cache.hpp"
 
 #include "merge_sort.hpp"
 void sort (pagelet& pg);
@@ -1508,3 +1509,230 @@ break_pages (array<page_item> l, space ph, int qual,
   tm_delete (H);
   return sk;
 }
+
+/******************************************************************************
+* Persistent page breaks
+******************************************************************************/
+
+// The digest consists of four independently mixed 32 bit words,
+// so that accidental collisions are extremely unlikely
+
+#define DIGEST_SIZE 4
+
+static inline unsigned int
+rotate_left (unsigned int x, int r) {
+  return (x << r) | (x >> (32 - r));
+}
+
+static void
+digest_add (unsigned int* h, int x) {
+  unsigned int u= (unsigned int) x;
+  h[0]= (h[0] ^ u) * 16777619U;
+  h[1]= (h[1] * 31U) + u + (h[1] >> 11);
+  unsigned int k= rotate_left (u * 0xcc9e2d51U, 15) * 0x1b873593U;
+  h[2]= rotate_left (h[2] ^ k, 13) * 5U + 0xe6546b64U;
+  h[3]= h[3] + u;
+  h[3]= h[3] + (h[3] << 10);
+  h[3]= h[3] ^ (h[3] >> 6);
+}
+
+static void
+digest_add (unsigned int* h, space spc) {
+  digest_add (h, spc->min);
+  digest_add (h, spc->def);
+  digest_add (h, spc->max);
+}
+
+static void
+digest_add (unsigned int* h, array<page_item> l) {
+  // the digest captures all information used by the page breaker
+  int i, n= N(l);
+  digest_add (h, n);
+  for (i=0; i<n; i++) {
+    page_item item= l[i];
+    bool last= (i == n-1) || (item->nr_cols != l[i+1]->nr_cols);
+    digest_add (h, item->type);
+    if (item->type == PAGE_CONTROL_ITEM) digest_add (h, hash (item->t));
+    digest_add (h, item->b->h ());
+    digest_add (h, item->b->y1);
+    digest_add (h, item->b->y2);
+    digest_add (h, item->spc);
+    digest_add (h, last? 0: item->penalty);
+    digest_add (h, item->nr_cols);
+    int j, k= N (item->fl);
+    digest_add (h, k);
+    for (j=0; j<k; j++) {
+      lazy_vstream ins= (lazy_vstream) item->fl[j];
+      digest_add (h, hash (ins->channel));
+      digest_add (h, ins->l);
+    }
+  }
+}
+
+static tree
+encode (space spc) {
+  return tuple (as_string (spc->min), as_string (spc->def),
+		as_string (spc->max));
+}
+
+static tree
+encode (path p) {
+  tree t (TUPLE);
+  for (; !is_nil (p); p= p->next) t << as_string (p->item);
+  return t;
+}
+
+static tree
+encode (skeleton sk) {
+  // (tuple (tuple ht pen exc stretch ins_1 ... ins_n) ...) where each
+  // ins_i= (tuple type begin end sk ht pen exc stretch top_cor bot_cor)
+  tree r (TUPLE);
+  for (int i=0; i<N(sk); i++) {
+    pagelet pg= sk[i];
+    tree t= tuple (encode (pg->ht), as_string (pg->pen->pen),
+		   as_string (pg->pen->exc),
+		   as_string ((int) (pg->stretch * 1.0e9)));
+    for (int j=0; j<N(pg->ins); j++) {
+      insertion ins= pg->ins[j];
+      tree u (TUPLE);
+      u << ins->type << encode (ins->begin) << encode (ins->end)
+	<< encode (ins->sk) << encode (ins->ht)
+	<< as_string (ins->pen->pen) << as_string (ins->pen->exc)
+	<< as_string ((int) (ins->stretch * 1.0e9))
+	<< as_string (ins->top_cor) << as_string (ins->bot_cor);
+      t << u;
+    }
+    r << t;
+  }
+  return r;
+}
+
+static bool
+is_int_tuple (tree t, int n) {
+  if (!is_tuple (t) || (n >= 0 && N(t) != n)) return false;
+  for (int i=0; i<N(t); i++)
+    if (!is_atomic (t[i]) || !is_int (t[i]->label)) return false;
+  return true;
+}
+
+static space
+decode_space (tree t) {
+  return space (as_int (t[0]), as_int (t[1]), as_int (t[2]));
+}
+
+static path
+decode_path (tree t) {
+  path p;
+  for (int i=N(t)-1; i>=0; i--) p= path (as_int (t[i]), p);
+  return p;
+}
+
+static bool
+decode_range (array<page_item> l, path p, path q) {
+  // check that sub (l, p, q) is well defined
+  if (is_nil (p) || is_nil (q)) return false;
+  if (is_atom (p) && is_atom (q))
+    return (0 <= p->item) && (p->item <= q->item) && (q->item <= N(l));
+  if ((N(p) <= 2) || (N(q) <= 2)) return false;
+  if ((p->item != q->item) || (p->next->item != q->next->item)) return false;
+  int i= p->item, j= p->next->item;
+  if ((i < 0) || (i >= N(l)) || (j < 0) || (j >= N (l[i]->fl))) return false;
+  lazy_vstream ins= (lazy_vstream) l[i]->fl[j];
+  return decode_range (ins->l, p->next->next, q->next->next);
+}
+
+static bool
+decode (tree r, array<page_item> l, skeleton& sk) {
+  if (!is_tuple (r)) return false;
+  sk= skeleton ();
+  for (int i=0; i<N(r); i++) {
+    tree t= r[i];
+    if (!is_tuple (t) || N(t) < 4 || !is_int_tuple (t[0], 3) ||
+	!is_int_tuple (t (1, 4), 3)) return false;
+    pagelet pg (decode_space (t[0]));
+    pg->pen    = vpenalty (as_int (t[1]), as_int (t[2]));
+    pg->stretch= as_int (t[3]) / 1.0e9;
+    for (int j=4; j<N(t); j++) {
+      tree u= t[j];
+      if (!is_tuple (u) || N(u) != 10 ||
+	  !is_int_tuple (u[1], -1) || !is_int_tuple (u[2], -1) ||
+	  !is_int_tuple (u[4], 3) || !is_int_tuple (u (5, 10), 5))
+	return false;
+      insertion ins (u[0], decode_path (u[1]), decode_path (u[2]));
+      if (!decode (u[3], l, ins->sk)) return false;
+      if (N (ins->sk) == 0 && !decode_range (l, ins->begin, ins->end))
+	return false;
+      ins->ht     = decode_space (u[4]);
+      ins->pen    = vpenalty (as_int (u[5]), as_int (u[6]));
+      ins->stretch= as_int (u[7]) / 1.0e9;
+      ins->top_cor= as_int (u[8]);
+      ins->bot_cor= as_int (u[9]);
+      pg->ins << ins;
+    }
+    sk << pg;
+  }
+  return true;
+}
+
+#define MAX_PAGE_DOCUMENTS 32
+
+static hashmap<string,tree>     page_key (UNINIT);
+static hashmap<string,skeleton> page_skeleton;
+
+skeleton
+break_pages (array<page_item> l, space ph, int qual,
+	     space fn_sep, space fnote_sep, space float_sep, font fn,
+	     string doc)
+{
+  // Page breaks of the document 'doc' are reused as long as the page
+  // items do not change, and remembered on disk by 'pages_memorize',
+  // so that they need not to be recomputed when reopening the document
+  if (doc == "")
+    return break_pages (l, ph, qual, fn_sep, fnote_sep, float_sep, fn);
+  unsigned int h[DIGEST_SIZE]= { 2166136261U, 0, 0x9747b28cU, 0 };
+  digest_add (h, l);
+  digest_add (h, ph);
+  digest_add (h, qual);
+  digest_add (h, fn_sep);
+  digest_add (h, fnote_sep);
+  digest_add (h, float_sep);
+  digest_add (h, fn->y1);
+  digest_add (h, fn->y2);
+  string s= as_string (N(l));
+  for (int i=0; i<DIGEST_SIZE; i++) s << ":" << as_string ((int) h[i]);
+  tree key= s;
+
+  if (page_key->contains (doc) && page_key[doc] == key)
+    return page_skeleton[doc];
+  skeleton sk;
+  cache_load ("page_cache.scm");
+  tree t= cache_get ("page_cache.scm", doc);
+  if (!is_tuple (t) || N(t) != 2 || t[0] != key || !decode (t[1], l, sk))
+    sk= break_pages (l, ph, qual, fn_sep, fnote_sep, float_sep, fn);
+  if (N (page_key) >= MAX_PAGE_DOCUMENTS && !page_key->contains (doc)) {
+    page_key     = hashmap<string,tree> (UNINIT);
+    page_skeleton= hashmap<string,skeleton> ();
+  }
+  page_key (doc)= key;
+  page_skeleton (doc)= sk;
+  return sk;
+}
+
+void
+pages_memorize (string doc) {
+  // Called when a document is saved or closed; only the page breaks
+  // of the most recently memorized documents are kept
+  if (!page_key->contains (doc)) return;
+  cache_load ("page_cache.scm");
+  cache_set ("page_cache.scm", doc,
+	     tuple (page_key[doc], encode (page_skeleton[doc])));
+  tree old= cache_get ("page_cache.scm", "");
+  tree docs= tuple (doc);
+  if (is_tuple (old))
+    for (int i=0; i<N(old); i++)
+      if (old[i] != doc) {
+	if (N(docs) < MAX_PAGE_DOCUMENTS) docs << old[i];
+	else cache_reset ("page_cache.scm", old[i]);
+      }
+  cache_set ("page_cache.scm", "", docs);
+}
@@ -50,6 +50,9 @@ public:
   SI           cur_top;
   array<box>   pages;
 
+  hashmap<string,box> old_pages;  // pages of the previous pass
+  hashmap<string,box> new_pages;  // pages of the current pass
+
   array<box>   lines_bx;
   array<space> lines_ht;
 
@@ -62,10 +65,15 @@ protected: // making papyrus boxes
   void papyrus_make (array<page_item> l);
 
 protected: // making page boxes
+  void pages_control (page_item item);
+  bool pages_key (string& key, array<page_item> l);
+  bool pages_key (string& key, insertion ins);
+  bool pages_key (string& key, pagelet pg);
   box  pages_format (array<page_item> l, SI ht, SI tcor, SI bcor);
   box  pages_format (insertion ins);
   box  pages_format (pagelet pg);
   box  pages_make_page (pagelet pg);
+  string pages_document ();
   void pages_make ();
   void papyrus_make ();
 
@@ -17,7 +17,7 @@
 * Cells
 ******************************************************************************/
 
-cell_rep::cell_rep (edit_env env2): var (""), env (env2) {}
+cell_rep::cell_rep (edit_env env2): var (""), env (env2), memo (0) {}
 
 void
 cell_rep::typeset (tree fm, tree t, path iq) {
@@ -35,13 +35,22 @@ cell_rep::typeset (tree fm, tree t, path iq) {
   }
   else {
     if (hyphen == "n") {
-      b= typeset_as_concat (env, t, iq);
-      if (vcorrect != "n") {
-	SI y1= b->y1;
-	SI y2= b->y2;
-	if ((vcorrect == "a") || (vcorrect == "b")) y1= min (y1, env->fn->y1);
-	if ((vcorrect == "a") || (vcorrect == "t")) y2= max (y2, env->fn->y2);
-	b= vresize_box (iq, b, y1, y2);
+      if (decoration != "" || !is_accessible (iq)) memo= 0;
+      if (memo == 2) b= table_memo_get (iq, fm, t);
+      if (is_nil (b)) {
+	int effects= env->side_effects;
+	b= typeset_as_concat (env, t, iq);
+	if (vcorrect != "n") {
+	  SI y1= b->y1;
+	  SI y2= b->y2;
+	  if ((vcorrect == "a") || (vcorrect == "b")) y1= min (y1,env->fn->y1);
+	  if ((vcorrect == "a") || (vcorrect == "t")) y2= max (y2,env->fn->y2);
+	  b= vresize_box (iq, b, y1, y2);
+	}
+	// Cells which access references or auxiliary data are typeset anew,
+	// so that these accesses are repeated on each pass
+	bool pure= !env->local_modified () && env->side_effects == effects;
+	if (memo != 0) table_memo_set (iq, fm, t, pure? b: box ());
       }
     }
     else {
@@ -23,7 +23,7 @@ lazy make_lazy_paragraph (edit_env env, array<box> bs, path ip);
 table_rep::table_rep (edit_env env2, int status2, int i0b, int j0b):
   var (""), env (env2), status (status2), i0 (i0b), j0 (j0b),
   T (NULL), nr_rows (0), mw (NULL), lw (NULL), rw (NULL),
-  width (0), height (0) {}
+  width (0), height (0), memo (false) {}
 
 table_rep::~table_rep () {
   if (T != NULL) {
@@ -83,9 +83,82 @@ table_rep::typeset (tree t, path iq) {
   env->local_end (CELL_FORMAT, old_format);
 }
 
+/******************************************************************************
+* Reusing the boxes of unchanged cells
+******************************************************************************/
+
+#define MAX_MEMO_TABLES 1024
+#define MAX_MEMO_CELLS  65536
+
+// The contents of a memorized cell carry a stamp observer, which
+// disappears as soon as the contents are modified.  This avoids
+// copying and comparing the contents of all cells on each pass.
+// Only the typesetting of the cells is saved in this way: the widths
+// and heights of the rows and columns are still recomputed from all
+// cell boxes whenever the table is retypeset.
+
+static hashmap<path,hashmap<string,tree> > memo_env;
+static hashmap<path,tree> memo_fm (UNINIT);
+static hashmap<path,int>  memo_stamp (0);
+static hashmap<path,box>  memo_box;
+
+void
+table_memo_reset () {
+  // References and other data outside the environment may have changed
+  memo_env  = hashmap<path,hashmap<string,tree> > ();
+  memo_fm   = hashmap<path,tree> (UNINIT);
+  memo_stamp= hashmap<path,int> (0);
+  memo_box  = hashmap<path,box> ();
+}
+
+static bool
+table_memo_env (edit_env env, path ip) {
+  // Cell boxes of a previous typesetting pass may only be reused
+  // if the table is typeset in the same environment
+  if (is_nil (ip) || !is_accessible (ip)) return false;
+  if (memo_env->contains (ip) && env->same_env (memo_env[ip])) return true;
+  if (N (memo_env) >= MAX_MEMO_TABLES)
+    memo_env= hashmap<path,hashmap<string,tree> > ();
+  env->read_env (memo_env (ip));
+  return false;
+}
+
+box
+table_memo_get (path ip, tree fm, tree t) {
+  int stamp;
+  if (!memo_box->contains (ip)) return box ();
+  if (!obtain_stamp (t, stamp) || stamp != memo_stamp [ip]) return box ();
+  if (memo_fm [ip] != fm) return box ();
+  return memo_box [ip];
+}
+
+void
+table_memo_set (path ip, tree fm, tree t, box b) {
+  if (is_nil (b)) {
+    memo_fm->reset (ip);
+    memo_stamp->reset (ip);
+    memo_box->reset (ip);
+    return;
+  }
+  if (N (memo_box) >= MAX_MEMO_CELLS && !memo_box->contains (ip)) {
+    memo_fm   = hashmap<path,tree> (UNINIT);
+    memo_stamp= hashmap<path,int> (0);
+    memo_box  = hashmap<path,box> ();
+  }
+  int stamp= attach_stamp (t);
+  memo_fm    (ip)= copy (fm);
+  memo_stamp (ip)= stamp;
+  memo_box   (ip)= b;
+}
+
+/******************************************************************************
+* Typesetting the cells
+******************************************************************************/
+
 void
 table_rep::typeset_table (tree fm, tree t, path ip) {
   int i;
+  memo= (status == 0) && table_memo_env (env, ip);
   nr_rows= N(t);
   nr_cols= 0;
   T= tm_new_array<cell*> (nr_rows);
@@ -115,7 +188,17 @@ table_rep::typeset_row (int i, tree fm, tree t, path ip) {
     cell& C= T[i][j];
     C= cell (env);
     tree old= env->local_begin (CELL_COL_NR, as_string (j));
-    C->typeset (subformat[j], t[j], descend (ip, j));
+    if (status == 0) {
+      // Once a cell modifies the environment, the remaining cells
+      // are typeset in a different environment than before
+      hashmap<string,tree> prev_back;
+      env->local_start (prev_back);
+      C->memo= (memo? 2: 1);
+      C->typeset (subformat[j], t[j], descend (ip, j));
+      if (env->local_modified ()) memo= false;
+      env->local_end (prev_back);
+    }
+    else C->typeset (subformat[j], t[j], descend (ip, j));
     env->local_end (CELL_COL_NR, old);
     C->row_span= min (C->row_span, nr_rows- i);
     C->col_span= min (C->col_span, nr_cols- j);
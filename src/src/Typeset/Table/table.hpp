@@ -60,6 +60,7 @@ public:
   string   hyphen;            // vertical hypenation
   int      row_origin;        // row span (not yet implemented)
   int      col_origin;        // column span (not yet implemented)
+  bool     memo;              // reuse the boxes of unchanged cells
 
   table_rep (edit_env env, int status, int i0, int j0);
   ~table_rep ();
@@ -137,6 +138,7 @@ public:
   int      col_span;          // column span
   table    D;                 // potential decoration
   table    T;                 // potential subtable
+  int      memo;              // 0: none, 1: memorize box, 2: also reuse it
 
   cell_rep (edit_env env);
 
@@ -157,4 +159,8 @@ class cell {
 };
 CONCRETE_NULL_CODE(cell);
 
+box  table_memo_get (path ip, tree fm, tree t);
+void table_memo_set (path ip, tree fm, tree t, box b);
+void table_memo_reset ();
+
 #endif // defined TABLE_H
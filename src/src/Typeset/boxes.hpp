@@ -290,6 +290,7 @@ path find_scrolled_tree_path (box b, path sp, SI x, SI y, SI delta);
 void find_canvas_info (box b, path sp, SI& x, SI& y, SI& sx, SI& sy,
 		       rectangle& outer, rectangle& inner);
 
+extern bool   enable_display_lists;
 extern bool   refresh_needed;
 extern time_t refresh_next;
 void          refresh_at (time_t t);
@@ -18,6 +18,7 @@
 #include "language.hpp"
 #include "path.hpp"
 #include "hashmap.hpp"
+#include "hashset.hpp"
 #include "boxes.hpp"
 #include "url.hpp"
 #include "frame.hpp"
@@ -120,6 +121,12 @@ public:
 private:
   hashmap<string,tree>         env;
   hashmap<string,tree>         back;
+  array<string>                memo_vars;   // variables read while memoizing
+  array<tree>                  memo_vals;   // and their values
+  int                          memo_level;  // nesting of memoized expansions
+  int                          memo_frame;  // innermost macro frame accessed
+  hashset<string>              reads;       // variables read by current bridge
+  int                          read_level;  // nesting of tracked bridges
 public:
   hashmap<string,path>         src;
   list<hashmap<string,tree> >  macro_arg;
@@ -135,6 +142,7 @@ public:
   hashmap<string,tree>&        local_aux;
   hashmap<string,tree>&        global_aux;
   bool                         complete;    // typeset complete document ?
+  int                          side_effects;// accesses to references and aux
   bool                         read_only;   // write-protected ?
   hashmap<string,tree>         missing;     // missing refs
   array<tree>                  redefined;   // redefined labels
@@ -209,7 +217,10 @@ private:
   void exec_until_with (tree t, path p);
   bool exec_until_with (tree t, path p, string var, int level);
   tree exec_drd_props (tree t);
+  void memo_read (string s);
+  bool memo_valid (tree e);
   tree exec_compound (tree t);
+  tree exec_macro (tree t);
   void exec_until_compound (tree t, path p);
   bool exec_until_compound (tree t, path p, string var, int level);
   tree exec_provides (tree t);
@@ -377,8 +388,16 @@ public:
   inline void assign (string s, tree t) {
     tree& val= env (s); t= exec(t); if (val != t) {
       back->write_back (s, env); val= t; update (s); } }
-  inline bool provides (string s) { return env->contains (s); }
-  inline tree read (string s) { return env [s]; }
+  inline void track_read (string s) {
+    if (read_level > 0) reads->insert (s); }
+  inline bool provides (string s) {
+    if (memo_level > 0) memo_read (s);
+    track_read (s);
+    return env->contains (s); }
+  inline tree read (string s) {
+    if (memo_level > 0) memo_read (s);
+    track_read (s);
+    return env [s]; }
   tree local_begin_extents (box b);
   void local_end_extents (tree t);
 
@@ -387,9 +406,16 @@ public:
   void monitored_patch_env (hashmap<string,tree> patch);
   void patch_env (hashmap<string,tree> patch);
   void read_env (hashmap<string,tree>& ret);
+  bool same_env (hashmap<string,tree> h);
   void local_start (hashmap<string,tree>& prev_back);
   void local_update (hashmap<string,tree>& oldpat, hashmap<string,tree>& chg);
+  bool local_modified ();
   void local_end (hashmap<string,tree>& prev_back);
+  void track_start (hashset<string>& prev_reads);
+  void track_end (hashset<string>& prev_reads, hashset<string>& r);
+  void track_join (hashset<string> r);
+  bool track_independent (hashset<string> r, hashmap<string,tree> oldpat);
+  void track_skip (hashmap<string,tree>& oldpat, hashmap<string,tree> chg);
 
   /* updating environment variables */
   ornament_parameters get_ornament_parameters ();
@@ -440,28 +466,35 @@ public:
   /* retrieving environment variables */
   inline bool get_bool (string var) {
     tree t= env [var];
+    track_read (var);
     if (is_compound (t)) return false;
     return as_bool (t->label); }
   inline int get_int (string var) {
     tree t= env [var];
+    track_read (var);
     if (is_compound (t)) return 0;
     return as_int (t->label); }
   inline double get_double (string var) {
     tree t= env [var];
+    track_read (var);
     if (is_compound (t)) return 0.0;
     return as_double (t->label); }
   inline string get_string (string var) {
     tree t= env [var];
+    track_read (var);
     if (is_compound (t)) return "";
     return t->label; }
   inline SI get_length (string var) {
     tree t= env [var];
+    track_read (var);
     return as_length (t); }
   inline space get_vspace (string var) {
     tree t= env [var];
+    track_read (var);
     return as_vspace (t); }
   inline color get_color (string var) {
     tree t= env [var];
+    track_read (var);
     return named_color (as_string (t), alpha); }
 
   friend class edit_env;